@@ -0,0 +1,145 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../automaton_algorithms.hpp"
+#include "../compiled_dfa.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    const size_t Text_size = 64 << 20;
+    const size_t Repetitions = 4;
+
+    // Words over the log alphabet ending with the keyword.
+    Automaton BuildKeywordNFA(std::string_view keyword)
+    {
+        std::set<Automaton::alpha_t> alphabet = {'\n'};
+        for (Automaton::alpha_t letter = ' '; letter <= '~'; ++letter)
+            alphabet.insert(letter);
+
+        Automaton automaton(alphabet, keyword.size() + 1);
+        for (auto letter : alphabet)
+            automaton.AddEdge(0, 0, letter);
+
+        for (size_t state = 0; state < keyword.size(); ++state)
+            automaton.AddEdge(state, state + 1, keyword[state]);
+
+        automaton.SetFinal(keyword.size());
+        return automaton;
+    }
+
+    std::string GenerateLog(size_t size)
+    {
+        static const char *Words[] = {"INFO", "DEBUG", "WARN", "ERROR", "request", "id=42", "user", "took", "12ms", "GET", "/index.html"};
+
+        std::mt19937 generator(19);
+        std::string log;
+        log.reserve(size + 64);
+
+        while (log.size() < size)
+        {
+            size_t words_in_line = 4 + generator() % 12;
+            for (size_t word = 0; word < words_in_line; ++word)
+            {
+                log += Words[generator() % std::size(Words)];
+                log += ' ';
+            }
+            log.back() = '\n';
+        }
+
+        return log;
+    }
+
+    // One table load per byte, as before acceleration.
+    CompiledDFA::state_t RunByteByByte(const CompiledDFA &automaton, std::string_view input)
+    {
+        auto state = automaton.GetStartState();
+        for (auto letter : input)
+            state = automaton.Step(state, static_cast<unsigned char>(letter));
+
+        return state;
+    }
+
+    void Report(const char *name, size_t bytes, double seconds)
+    {
+        std::cout << "    " << name << ": " << static_cast<double>(bytes) / seconds / 1e9 << " GB/s\n";
+    }
+
+    void CompareWholeText(const char *keyword, const std::string &log)
+    {
+        using namespace AutomatonTransformer;
+        CompiledDFA automaton(MCDFAFromCDFA(CDFAFromDFA(DFAFromNFA(BuildKeywordNFA(keyword)))));
+
+        std::cout << "    keyword \"" << keyword << "\": " << automaton.GetNumberOfStates() << " states, "
+                  << automaton.GetNumberOfAcceleratedStates() << " accelerated\n";
+
+        size_t accepted = 0;
+        Benchmarks::Timer plain_timer;
+        for (size_t repetition = 0; repetition < Repetitions; ++repetition)
+            accepted += automaton.IsAccepting(RunByteByByte(automaton, log));
+
+        Report("  byte by byte", Repetitions * log.size(), plain_timer.GetSeconds());
+
+        Benchmarks::Timer accelerated_timer;
+        for (size_t repetition = 0; repetition < Repetitions; ++repetition)
+            accepted -= automaton.Accepts(log);
+
+        Report("  accelerated", Repetitions * log.size(), accelerated_timer.GetSeconds());
+
+        if (accepted != 0)
+            std::cout << "    results differ\n";
+    }
+};
+
+void Benchmarks::AcceleratedScanning()
+{
+    using namespace AutomatonTransformer;
+
+    auto log = GenerateLog(Text_size);
+
+    CompareWholeText("panic", log);
+    CompareWholeText("ERROR", log);
+    CompareWholeText("took 12ms", log);
+
+    std::vector<std::string_view> lines;
+    for (size_t begin = 0, end = 0; begin < log.size(); begin = end + 1)
+    {
+        end = log.find('\n', begin);
+        if (end == std::string::npos)
+            end = log.size();
+
+        lines.push_back(std::string_view(log).substr(begin, end - begin));
+    }
+
+    // Lines ending with a digit: no state loops on most letters.
+    Automaton ends_with_digit = BuildKeywordNFA("");
+    ends_with_digit.AddState(1);
+    for (Automaton::alpha_t digit = '0'; digit <= '9'; ++digit)
+        ends_with_digit.AddEdge(0, 1, digit);
+
+    ends_with_digit.SetFinal(0, false);
+    ends_with_digit.SetFinal(1);
+    CompiledDFA automaton(MCDFAFromCDFA(CDFAFromDFA(DFAFromNFA(ends_with_digit))));
+
+    size_t accepted = 0;
+    Timer single_timer;
+    for (size_t repetition = 0; repetition < Repetitions; ++repetition)
+    {
+        for (auto line : lines)
+            accepted += automaton.IsAccepting(RunByteByByte(automaton, line));
+    }
+
+    Report("lines one by one", Repetitions * log.size(), single_timer.GetSeconds());
+
+    Timer interleaved_timer;
+    for (size_t repetition = 0; repetition < Repetitions; ++repetition)
+        accepted -= automaton.CountAccepted(lines);
+
+    Report("lines interleaved", Repetitions * log.size(), interleaved_timer.GetSeconds());
+
+    if (accepted != 0)
+        std::cout << "    results differ\n";
+}
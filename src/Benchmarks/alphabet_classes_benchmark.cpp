@@ -0,0 +1,77 @@
+#include <iostream>
+#include <vector>
+
+#include "../automaton_algorithms.hpp"
+#include "../compiled_dfa.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    const size_t Distance_from_end = 11;
+
+    // Printable text with a digit at the given distance from the end: the
+    // alphabet has 96 letters, but only digits and the other letters differ.
+    Automaton BuildDigitFromEndNFA(size_t distance)
+    {
+        std::set<Automaton::alpha_t> alphabet = {'\n'};
+        for (Automaton::alpha_t letter = ' '; letter <= '~'; ++letter)
+            alphabet.insert(letter);
+
+        Automaton automaton(alphabet, distance + 1);
+        for (auto letter : alphabet)
+        {
+            automaton.AddEdge(0, 0, letter);
+            for (size_t state = 1; state < distance; ++state)
+                automaton.AddEdge(state, state + 1, letter);
+        }
+
+        for (Automaton::alpha_t digit = '0'; digit <= '9'; ++digit)
+            automaton.AddEdge(0, 1, digit);
+
+        automaton.SetFinal(distance);
+        return automaton;
+    }
+
+    void Report(const char *name, double seconds)
+    {
+        std::cout << "    " << name << ": " << seconds << " s\n";
+    }
+};
+
+void Benchmarks::AlphabetClasses()
+{
+    using namespace AutomatonTransformer;
+
+    auto nfa = BuildDigitFromEndNFA(Distance_from_end);
+
+    std::vector<uint32_t> classes;
+    size_t number_of_classes = FlatAutomaton(nfa).GetSymbolClasses(classes);
+    std::cout << "    " << nfa.GetAlphabet().size() << " letters in " << number_of_classes << " classes\n";
+
+    Timer determinization_timer;
+    auto dfa = DFAFromNFA(nfa);
+    Report("DFAFromNFA", determinization_timer.GetSeconds());
+
+    Timer completion_timer;
+    auto cdfa = CDFAFromDFA(dfa);
+    Report("CDFAFromDFA", completion_timer.GetSeconds());
+
+    Timer moore_timer;
+    auto moore = MCDFAFromCDFA(cdfa, MinimizationAlgorithm::Moore);
+    Report("Moore", moore_timer.GetSeconds());
+
+    Timer hopcroft_timer;
+    auto hopcroft = MCDFAFromCDFA(cdfa, MinimizationAlgorithm::Hopcroft);
+    Report("Hopcroft", hopcroft_timer.GetSeconds());
+
+    Timer flat_timer;
+    auto dense = MCDFAFromCDFA(DFAFromNFA(FlatAutomaton(nfa)));
+    Report("flat DFAFromNFA + Hopcroft", flat_timer.GetSeconds());
+
+    CompiledDFA compiled(dense);
+    std::cout << "    " << dfa.GetNumberOfStates() << " DFA states, " << moore.GetNumberOfStates() << " minimal, "
+              << compiled.GetNumberOfByteClasses() << " byte classes, rows of " << compiled.GetRowSize() << " states\n";
+
+    if (moore.GetNumberOfStates() != hopcroft.GetNumberOfStates() || hopcroft.GetNumberOfStates() != dense.GetNumberOfStates())
+        std::cout << "    results differ\n";
+}
@@ -0,0 +1,122 @@
+#include <random>
+
+#include "automaton_generators.hpp"
+
+namespace
+{
+    const size_t Epsilon_period = 8;
+    const size_t Final_period = 7;
+
+    std::set<Automaton::alpha_t> GetLetters(size_t number_of_letters)
+    {
+        std::set<Automaton::alpha_t> alphabet;
+        for (size_t letter = 0; letter < number_of_letters; ++letter)
+            alphabet.insert(static_cast<Automaton::alpha_t>('a' + letter));
+
+        return alphabet;
+    }
+
+    Automaton::alpha_t GetLetter(size_t index, size_t number_of_letters)
+    {
+        return static_cast<Automaton::alpha_t>('a' + index % number_of_letters);
+    }
+
+    // Edges state -> state + 1 by the letters in turn, and epsilon edges over
+    // every Epsilon_period-th of them.
+    void AddPath(Automaton &automaton, size_t number_of_states, size_t length, size_t number_of_letters)
+    {
+        for (size_t state = 0; state < length; ++state)
+        {
+            size_t next = (state + 1) % number_of_states;
+            automaton.AddEdge(state, next, GetLetter(state, number_of_letters));
+
+            if (state % Epsilon_period == Epsilon_period - 1)
+                automaton.AddEdge(state, next, Automaton::Epsilon);
+        }
+    }
+};
+
+Automaton Benchmarks::RandomNFA(uint32_t seed, size_t number_of_states, size_t number_of_letters,
+                                size_t edges_per_letter, double epsilon_probability)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> probability(0, 1);
+
+    auto alphabet = GetLetters(number_of_letters);
+    Automaton automaton(alphabet, number_of_states);
+
+    for (size_t state = 0; state < number_of_states; ++state)
+    {
+        for (auto letter : alphabet)
+        {
+            for (size_t edge = 0; edge < edges_per_letter; ++edge)
+                automaton.AddEdge(state, generator() % number_of_states, letter);
+        }
+
+        if (probability(generator) < epsilon_probability)
+            automaton.AddEdge(state, generator() % number_of_states, Automaton::Epsilon);
+
+        automaton.SetFinal(state, generator() % 4 == 0);
+    }
+
+    return automaton;
+}
+
+Automaton Benchmarks::RandomDFA(uint32_t seed, size_t number_of_states, size_t number_of_letters, double missing_probability)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> probability(0, 1);
+
+    auto alphabet = GetLetters(number_of_letters);
+    Automaton automaton(alphabet, number_of_states);
+
+    for (size_t state = 0; state < number_of_states; ++state)
+    {
+        for (auto letter : alphabet)
+        {
+            if (probability(generator) >= missing_probability)
+                automaton.AddEdge(state, generator() % number_of_states, letter);
+        }
+
+        automaton.SetFinal(state, generator() % 2 == 0);
+    }
+
+    return automaton;
+}
+
+Automaton Benchmarks::NthFromEndNFA(size_t n)
+{
+    Automaton automaton({'a', 'b'}, n + 1);
+    automaton.AddEdge(0, 0, 'a');
+    automaton.AddEdge(0, 0, 'b');
+    automaton.AddEdge(0, 1, 'a');
+
+    for (size_t state = 1; state < n; ++state)
+    {
+        automaton.AddEdge(state, state + 1, 'a');
+        automaton.AddEdge(state, state + 1, 'b');
+    }
+
+    automaton.SetFinal(n);
+    return automaton;
+}
+
+Automaton Benchmarks::ChainNFA(size_t number_of_states, size_t number_of_letters)
+{
+    Automaton automaton(GetLetters(number_of_letters), number_of_states);
+    AddPath(automaton, number_of_states, number_of_states - 1, number_of_letters);
+    automaton.SetFinal(number_of_states - 1);
+
+    return automaton;
+}
+
+Automaton Benchmarks::CycleNFA(size_t number_of_states, size_t number_of_letters)
+{
+    Automaton automaton(GetLetters(number_of_letters), number_of_states);
+    AddPath(automaton, number_of_states, number_of_states, number_of_letters);
+
+    for (size_t state = 0; state < number_of_states; state += Final_period)
+        automaton.SetFinal(state);
+
+    return automaton;
+}
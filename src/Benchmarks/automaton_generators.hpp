@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../automaton.hpp"
+
+// Seeded synthetic automata over the letters 'a', 'b', ...: the same
+// arguments always give the same automaton.
+namespace Benchmarks
+{
+    // Every state has edges_per_letter random targets by every letter, an
+    // epsilon edge with the given probability and is final with probability 1/4.
+    Automaton RandomNFA(uint32_t seed, size_t number_of_states, size_t number_of_letters,
+                        size_t edges_per_letter, double epsilon_probability);
+
+    // Transitions are missing with the given probability; half of the states are final.
+    Automaton RandomDFA(uint32_t seed, size_t number_of_states, size_t number_of_letters, double missing_probability);
+
+    // Words over {a, b} whose n-th letter from the end is a: n + 1 states,
+    // but 2^n states in the DFA.
+    Automaton NthFromEndNFA(size_t n);
+
+    // A path reading the letters in turn, with an epsilon edge skipping every
+    // eighth letter. Only the end is final.
+    Automaton ChainNFA(size_t number_of_states, size_t number_of_letters);
+
+    // The same path closed into a cycle, final in every seventh state.
+    Automaton CycleNFA(size_t number_of_states, size_t number_of_letters);
+};
@@ -0,0 +1,52 @@
+#include <cstring>
+#include <iostream>
+
+#include "benchmarks.hpp"
+
+namespace
+{
+    struct Benchmark
+    {
+        const char *name;
+        void (*run)();
+    };
+
+    const Benchmark All_benchmarks[] =
+    {
+        {"compiled_dfa", Benchmarks::CompiledDFAThroughput},
+        {"regex_compiler", Benchmarks::RegExprCompilation},
+        {"multi_pattern", Benchmarks::MultiPatternMatching},
+        {"regexpr", Benchmarks::RegExprElimination},
+        {"streaming", Benchmarks::StreamingMatching},
+        {"accelerated_scan", Benchmarks::AcceleratedScanning},
+        {"alphabet_classes", Benchmarks::AlphabetClasses},
+        {"stages", Benchmarks::TransformerStages},
+        {"brzozowski", Benchmarks::BrzozowskiMinimization},
+        {"nfa_reduction", Benchmarks::NFAReduction},
+    };
+};
+
+int main(int argc, char *argv[])
+{
+    bool found = argc < 2;
+    for (auto &benchmark : All_benchmarks)
+    {
+        if (argc >= 2 && std::strcmp(argv[1], benchmark.name) != 0)
+            continue;
+
+        found = true;
+        std::cout << "[" << benchmark.name << "]\n";
+        benchmark.run();
+    }
+
+    if (!found)
+    {
+        std::cout << "Unknown benchmark: \"" << argv[1] << "\". Available benchmarks:\n";
+        for (auto &benchmark : All_benchmarks)
+            std::cout << "    " << benchmark.name << "\n";
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+
+namespace Benchmarks
+{
+    class Timer
+    {
+        public:
+            Timer(): start_(std::chrono::steady_clock::now()) {}
+
+            double GetSeconds() const
+            {
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+            }
+
+        private:
+            std::chrono::steady_clock::time_point start_;
+    };
+
+    void CompiledDFAThroughput();
+    void RegExprCompilation();
+    void MultiPatternMatching();
+    void RegExprElimination();
+    void StreamingMatching();
+    void AcceleratedScanning();
+    void AlphabetClasses();
+    void TransformerStages();
+    void BrzozowskiMinimization();
+    void NFAReduction();
+};
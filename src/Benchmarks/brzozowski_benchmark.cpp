@@ -0,0 +1,55 @@
+#include <iostream>
+#include <string>
+
+#include "../automaton_algorithms.hpp"
+#include "automaton_generators.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    // Words whose n-th letter from the end is a, or any word: the subset
+    // construction still makes 2^n states, but the minimal DFA has one, and
+    // the reversed language has a DFA of about n states.
+    Automaton BuildRedundantNFA(size_t n)
+    {
+        auto automaton = Benchmarks::NthFromEndNFA(n);
+        automaton.SetFinal(0);
+
+        return automaton;
+    }
+
+    // Subset construction followed by Hopcroft against double reversal.
+    void Compare(const std::string &name, const Automaton &nfa)
+    {
+        using namespace AutomatonTransformer;
+
+        Benchmarks::Timer subsets_timer;
+        Automaton eps_free = nfa;
+        RemoveEpsTransitions(eps_free);
+        auto dfa = DFAFromNFA(eps_free);
+        auto hopcroft = MCDFAFromCDFA(CDFAFromDFA(dfa), MinimizationAlgorithm::Hopcroft);
+        double subsets_seconds = subsets_timer.GetSeconds();
+
+        Benchmarks::Timer brzozowski_timer;
+        auto brzozowski = MCDFAFromNFA(nfa);
+        double brzozowski_seconds = brzozowski_timer.GetSeconds();
+
+        std::cout << "    " << name << ": " << nfa.GetNumberOfStates() << " NFA states, " << dfa.GetNumberOfStates()
+                  << " DFA states, " << hopcroft.GetNumberOfStates() << " minimal\n"
+                  << "        DFAFromNFA + Hopcroft: " << subsets_seconds << " s\n"
+                  << "        Brzozowski: " << brzozowski_seconds << " s\n";
+
+        if (brzozowski.GetNumberOfStates() != hopcroft.GetNumberOfStates())
+            std::cout << "        results differ\n";
+    }
+};
+
+void Benchmarks::BrzozowskiMinimization()
+{
+    Compare("redundant_nth_from_end(16)", BuildRedundantNFA(16));
+    Compare("nth_from_end(16)", NthFromEndNFA(16));
+    Compare("random_nfa(20,2,2)", RandomNFA(1, 20, 2, 2, 0.2));
+    Compare("random_nfa(24,3,1)", RandomNFA(4, 24, 3, 1, 0.05));
+    Compare("chain(20000,2)", ChainNFA(20000, 2));
+    Compare("cycle(1000,3)", CycleNFA(1000, 3));
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../automaton_algorithms.hpp"
+#include "../compiled_dfa.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    const size_t Text_size = 64 << 20;
+    const size_t Repetitions = 4;
+    const char *Pattern = "ERROR";
+
+    std::set<Automaton::alpha_t> GetLogAlphabet()
+    {
+        std::set<Automaton::alpha_t> alphabet = {'\n'};
+        for (Automaton::alpha_t letter = ' '; letter <= '~'; ++letter)
+            alphabet.insert(letter);
+
+        return alphabet;
+    }
+
+    // Words over the log alphabet ending with the pattern, or containing it
+    // if contains is set.
+    Automaton BuildPatternNFA(bool contains)
+    {
+        std::string_view pattern = Pattern;
+        Automaton automaton(GetLogAlphabet(), pattern.size() + 1);
+
+        for (auto letter : automaton.GetAlphabet())
+        {
+            automaton.AddEdge(0, 0, letter);
+            if (contains)
+                automaton.AddEdge(pattern.size(), pattern.size(), letter);
+        }
+
+        for (size_t state = 0; state < pattern.size(); ++state)
+            automaton.AddEdge(state, state + 1, pattern[state]);
+
+        automaton.SetFinal(pattern.size());
+        return automaton;
+    }
+
+    CompiledDFA Compile(const Automaton &automaton)
+    {
+        using namespace AutomatonTransformer;
+        return CompiledDFA(MCDFAFromCDFA(CDFAFromDFA(DFAFromNFA(automaton))));
+    }
+
+    std::string GenerateLog(size_t size)
+    {
+        static const char *Words[] = {"INFO", "DEBUG", "WARN", "ERROR", "request", "id=42", "user", "took", "12ms", "GET", "/index.html"};
+
+        std::mt19937 generator(42);
+        std::string log;
+        log.reserve(size + 64);
+
+        while (log.size() < size)
+        {
+            size_t words_in_line = 4 + generator() % 12;
+            for (size_t word = 0; word < words_in_line; ++word)
+            {
+                log += Words[generator() % std::size(Words)];
+                log += ' ';
+            }
+            log.back() = '\n';
+        }
+
+        return log;
+    }
+
+    void Report(const char *name, size_t bytes, double seconds)
+    {
+        std::cout << "    " << name << ": " << static_cast<double>(bytes) / seconds / 1e9 << " GB/s\n";
+    }
+};
+
+void Benchmarks::CompiledDFAThroughput()
+{
+    auto log = GenerateLog(Text_size);
+
+    std::vector<std::string_view> lines;
+    for (size_t begin = 0, end = 0; begin < log.size(); begin = end + 1)
+    {
+        end = log.find('\n', begin);
+        if (end == std::string::npos)
+            end = log.size();
+
+        lines.push_back(std::string_view(log).substr(begin, end - begin));
+    }
+
+    auto ends_with = Compile(BuildPatternNFA(false));
+    auto contains = Compile(BuildPatternNFA(true));
+
+    size_t accepted = 0;
+    Timer whole_text_timer;
+    for (size_t repetition = 0; repetition < Repetitions; ++repetition)
+        accepted += ends_with.Accepts(log);
+
+    Report("Accepts (whole text)", Repetitions * log.size(), whole_text_timer.GetSeconds());
+
+    Timer batch_timer;
+    for (size_t repetition = 0; repetition < Repetitions; ++repetition)
+        accepted += contains.CountAccepted(lines);
+
+    Report("CountAccepted (per line)", Repetitions * log.size(), batch_timer.GetSeconds());
+
+    std::cout << "    states: " << contains.GetNumberOfStates() << ", accepted lines: " << accepted / Repetitions << "\n";
+}
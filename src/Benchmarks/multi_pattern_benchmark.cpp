@@ -0,0 +1,134 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../automaton_algorithms.hpp"
+#include "../compiled_dfa.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    const size_t Text_size = 16 << 20;
+    const char *Keywords[] = {"ERROR", "WARN", "timeout", "user", "GET", "POST", "id=42", "took", "12ms", "index",
+                              "DEBUG", "panic", "refused", "request", "html", "denied"};
+
+    // Words over the log alphabet ending with the keyword.
+    Automaton BuildKeywordNFA(std::string_view keyword)
+    {
+        std::set<Automaton::alpha_t> alphabet = {'\n'};
+        for (Automaton::alpha_t letter = ' '; letter <= '~'; ++letter)
+            alphabet.insert(letter);
+
+        Automaton automaton(alphabet, keyword.size() + 1);
+        for (auto letter : alphabet)
+            automaton.AddEdge(0, 0, letter);
+
+        for (size_t state = 0; state < keyword.size(); ++state)
+            automaton.AddEdge(state, state + 1, keyword[state]);
+
+        automaton.SetFinal(keyword.size());
+        return automaton;
+    }
+
+    // The same language with an epsilon edge into the looping state and after
+    // every letter of the keyword.
+    Automaton BuildEpsilonKeywordNFA(std::string_view keyword)
+    {
+        std::set<Automaton::alpha_t> alphabet = {'\n'};
+        for (Automaton::alpha_t letter = ' '; letter <= '~'; ++letter)
+            alphabet.insert(letter);
+
+        Automaton automaton(alphabet, 2 * keyword.size() + 2);
+        automaton.SetStartState(2 * keyword.size() + 1);
+        automaton.AddEdge(automaton.GetStartState(), 0, Automaton::Epsilon);
+        for (auto letter : alphabet)
+            automaton.AddEdge(0, 0, letter);
+
+        for (size_t position = 0; position < keyword.size(); ++position)
+        {
+            automaton.AddEdge(2 * position, 2 * position + 1, keyword[position]);
+            automaton.AddEdge(2 * position + 1, 2 * position + 2, Automaton::Epsilon);
+        }
+
+        automaton.SetFinal(2 * keyword.size());
+        return automaton;
+    }
+
+    std::string GenerateText(size_t size)
+    {
+        static const char *Words[] = {"INFO", "DEBUG", "WARN", "ERROR", "request", "id=42", "user", "took", "12ms", "GET", "/index.html"};
+
+        std::mt19937 generator(7);
+        std::string text;
+        text.reserve(size + 64);
+
+        while (text.size() < size)
+        {
+            text += Words[generator() % std::size(Words)];
+            text += generator() % 8 == 0 ? '\n' : ' ';
+        }
+
+        return text;
+    }
+
+    void Report(const char *name, size_t bytes, double seconds)
+    {
+        std::cout << "    " << name << ": " << static_cast<double>(bytes) / seconds / 1e6 << " MB/s\n";
+    }
+};
+
+void Benchmarks::MultiPatternMatching()
+{
+    using namespace AutomatonTransformer;
+
+    auto text = GenerateText(Text_size);
+
+    std::vector<Automaton> patterns;
+    for (auto keyword : Keywords)
+        patterns.push_back(BuildKeywordNFA(keyword));
+
+    Timer build_timer;
+    CompiledDFA combined(MultiPatternDFA(patterns));
+    std::cout << "    build of the combined DFA: " << build_timer.GetSeconds() << " s, "
+              << combined.GetNumberOfStates() << " states\n";
+
+    std::vector<CompiledDFA> separate;
+    for (auto &pattern : patterns)
+        separate.emplace_back(MCDFAFromCDFA(CDFAFromDFA(DFAFromNFA(FlatAutomaton(pattern)))));
+
+    std::vector<size_t> separate_counts(patterns.size(), 0);
+    Timer separate_timer;
+    for (size_t pattern = 0; pattern < separate.size(); ++pattern)
+        separate[pattern].Scan(text, [&](size_t, std::span<const uint32_t>) { ++separate_counts[pattern]; });
+
+    Report("one pass per pattern", text.size(), separate_timer.GetSeconds());
+
+    std::vector<size_t> combined_counts(patterns.size(), 0);
+    Timer combined_timer;
+    combined.Scan(text, [&](size_t, std::span<const uint32_t> ids)
+    {
+        for (auto id : ids)
+            ++combined_counts[id];
+    });
+
+    Report("one pass for all patterns", text.size(), combined_timer.GetSeconds());
+
+    if (separate_counts != combined_counts)
+        std::cout << "    match counts differ!\n";
+
+    std::vector<Automaton> epsilon_patterns;
+    for (auto keyword : Keywords)
+        epsilon_patterns.push_back(BuildEpsilonKeywordNFA(keyword));
+
+    std::vector<size_t> epsilon_counts(patterns.size(), 0);
+    CompiledDFA(MultiPatternDFA(epsilon_patterns)).Scan(text, [&](size_t, std::span<const uint32_t> ids)
+    {
+        for (auto id : ids)
+            ++epsilon_counts[id];
+    });
+
+    if (epsilon_counts != combined_counts)
+        std::cout << "    match counts of the patterns with epsilon edges differ!\n";
+}
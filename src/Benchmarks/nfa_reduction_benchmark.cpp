@@ -0,0 +1,99 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../automaton_algorithms.hpp"
+#include "automaton_generators.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    // Simulation keeps a table of pairs of states.
+    const size_t Max_simulation_states = 4096;
+
+    // Words whose n-th letter from the end is a, or any word: the final start
+    // state simulates every other state.
+    Automaton BuildRedundantNFA(size_t n)
+    {
+        auto automaton = Benchmarks::NthFromEndNFA(n);
+        automaton.SetFinal(0);
+
+        return automaton;
+    }
+
+    // Copies of the same NFA behind epsilon edges from a new start state, as
+    // a union of patterns often has.
+    Automaton BuildCopies(const Automaton &automaton, size_t number_of_copies)
+    {
+        size_t number_of_states = automaton.GetNumberOfStates();
+        Automaton copies(automaton.GetAlphabet(), number_of_states * number_of_copies + 1);
+        copies.SetStartState(number_of_states * number_of_copies);
+
+        for (size_t copy = 0; copy < number_of_copies; ++copy)
+        {
+            size_t offset = copy * number_of_states;
+            copies.AddEdge(copies.GetStartState(), offset + automaton.GetStartState(), Automaton::Epsilon);
+
+            for (auto state : automaton.GetStateNumbers())
+            {
+                copies.SetFinal(offset + state, automaton.IsStateFinal(state));
+                for (auto &[alpha, neighbours] : automaton.GetNeighbours(state))
+                {
+                    for (auto neighbour : neighbours)
+                        copies.AddEdge(offset + state, offset + neighbour, alpha);
+                }
+            }
+        }
+
+        return copies;
+    }
+
+    void Report(const char *name, const Automaton &input, const Automaton &nfa, double reduction_seconds)
+    {
+        if (!AutomatonTransformer::Equivalent(input, nfa))
+        {
+            std::cerr << "The " << name << " reduction changed the language.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        Benchmarks::Timer timer;
+        auto dfa = AutomatonTransformer::DFAFromNFA(nfa);
+        double seconds = timer.GetSeconds();
+
+        std::cout << "        " << name << ": " << nfa.GetNumberOfStates() << " NFA states in " << reduction_seconds
+                  << " s, " << dfa.GetNumberOfStates() << " DFA states in " << seconds << " s\n";
+    }
+
+    void Compare(const std::string &name, const Automaton &input)
+    {
+        using namespace AutomatonTransformer;
+
+        Automaton nfa = input;
+        RemoveEpsTransitions(nfa);
+        Trim(nfa);
+
+        std::cout << "    " << name << ":\n";
+        Report("trimmed", input, nfa, 0);
+
+        Benchmarks::Timer bisimulation_timer;
+        auto bisimulation = ReduceNFA(nfa, NFAReduction::Bisimulation);
+        Report("bisimulation", input, bisimulation, bisimulation_timer.GetSeconds());
+
+        if (nfa.GetNumberOfStates() > Max_simulation_states)
+            return;
+
+        Benchmarks::Timer simulation_timer;
+        auto simulation = ReduceNFA(nfa, NFAReduction::Simulation);
+        Report("simulation", input, simulation, simulation_timer.GetSeconds());
+    }
+};
+
+void Benchmarks::NFAReduction()
+{
+    Compare("redundant_nth_from_end(16)", BuildRedundantNFA(16));
+    Compare("copies(nth_from_end(14),8)", BuildCopies(NthFromEndNFA(14), 8));
+    Compare("random_nfa(20,2,2)", RandomNFA(1, 20, 2, 2, 0.2));
+    Compare("random_nfa(32,4,1)", RandomNFA(2, 32, 4, 1, 0.05));
+    Compare("copies(random_nfa(32,4,1),4)", BuildCopies(RandomNFA(2, 32, 4, 1, 0.05), 4));
+    Compare("cycle(1000,3)", CycleNFA(1000, 3));
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../automaton_algorithms.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    const size_t Number_of_patterns = 20000;
+    const size_t Pattern_depth = 7;
+
+    std::string GeneratePattern(std::mt19937 &generator, size_t depth)
+    {
+        if (depth == 0)
+            return std::string(1, static_cast<char>('a' + generator() % 26));
+
+        switch (generator() % 6)
+        {
+            case 0:
+                return "(" + GeneratePattern(generator, depth - 1) + " + " + GeneratePattern(generator, depth - 1) + ")";
+            case 1:
+                return "(" + GeneratePattern(generator, depth - 1) + ")*";
+            case 2:
+                return std::string(1, static_cast<char>('a' + generator() % 26));
+            default:
+                return GeneratePattern(generator, depth - 1) + GeneratePattern(generator, depth - 1);
+        }
+    }
+
+    void Report(const char *name, size_t number_of_patterns, size_t bytes, double seconds)
+    {
+        std::cout << "    " << name << ": " << static_cast<double>(number_of_patterns) / seconds << " patterns/s, "
+                  << static_cast<double>(bytes) / seconds / 1e6 << " MB/s\n";
+    }
+};
+
+void Benchmarks::RegExprCompilation()
+{
+    std::mt19937 generator(42);
+
+    std::vector<std::string> patterns(Number_of_patterns);
+    size_t bytes = 0;
+    for (auto &pattern : patterns)
+    {
+        pattern = GeneratePattern(generator, Pattern_depth);
+        bytes += pattern.size();
+    }
+
+    size_t number_of_states = 0;
+    {
+        Timer timer;
+        std::vector<Automaton> automata;
+        automata.reserve(patterns.size());
+
+        for (auto &pattern : patterns)
+            automata.push_back(AutomatonTransformer::AutomatonFromRegExpr(pattern));
+
+        for (auto &automaton : automata)
+            number_of_states += automaton.GetNumberOfStates();
+
+        automata.clear();
+        Report("AutomatonFromRegExpr (default resource)", patterns.size(), bytes, timer.GetSeconds());
+    }
+
+    {
+        Timer timer;
+        std::pmr::monotonic_buffer_resource arena;
+        std::vector<Automaton> automata;
+        automata.reserve(patterns.size());
+
+        for (auto &pattern : patterns)
+            automata.push_back(AutomatonTransformer::AutomatonFromRegExpr(pattern, &arena));
+
+        automata.clear();
+        Report("AutomatonFromRegExpr (monotonic arena)", patterns.size(), bytes, timer.GetSeconds());
+    }
+
+    std::cout << "    patterns: " << patterns.size() << ", pattern bytes: " << bytes << ", states: " << number_of_states << "\n";
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <string>
+
+#include "../automaton_algorithms.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    const size_t Chain_length = 4000;
+    const size_t Number_of_cycles = 1000;
+
+    // Words over {a, b} with a block of Chain_length letters a: every b
+    // returns to the start.
+    Automaton BuildChain()
+    {
+        Automaton automaton({'a', 'b'}, Chain_length + 1);
+        for (size_t state = 0; state < Chain_length; ++state)
+        {
+            automaton.AddEdge(state, state + 1, 'a');
+            automaton.AddEdge(state, 0, 'b');
+        }
+
+        automaton.AddEdge(Chain_length, Chain_length, 'a');
+        automaton.AddEdge(Chain_length, Chain_length, 'b');
+        automaton.SetFinal(Chain_length);
+
+        return automaton;
+    }
+
+    // Cycles of three states hanging off the start state.
+    Automaton BuildCycles()
+    {
+        Automaton automaton({'a', 'b', 'c'}, 2 * Number_of_cycles + 1);
+        for (size_t cycle = 0; cycle < Number_of_cycles; ++cycle)
+        {
+            size_t first = 2 * cycle + 1;
+            automaton.AddEdge(0, first, static_cast<Automaton::alpha_t>('a' + cycle % 3));
+            automaton.AddEdge(first, first + 1, 'b');
+            automaton.AddEdge(first + 1, 0, 'c');
+            automaton.SetFinal(first + 1);
+        }
+
+        return automaton;
+    }
+
+    void Run(const char *name, const Automaton &automaton)
+    {
+        Benchmarks::Timer timer;
+        auto expression = AutomatonTransformer::RegExpr(automaton);
+        double seconds = timer.GetSeconds();
+
+        std::cout << "    " << name << ": " << automaton.GetNumberOfStates() << " states, " << seconds << " s, "
+                  << expression.size() << " characters\n";
+    }
+};
+
+void Benchmarks::RegExprElimination()
+{
+    Run("chain", BuildChain());
+    Run("cycles", BuildCycles());
+}
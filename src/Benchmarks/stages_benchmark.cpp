@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/resource.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "../automaton_algorithms.hpp"
+#include "../automaton_statistics.hpp"
+#include "automaton_generators.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    // Moore needs a round per letter of the longest word telling two states
+    // apart, and state elimination grows the expressions, so on bigger
+    // automata they take minutes.
+    const size_t Max_moore_states = 4096;
+    const size_t Max_regexpr_states = 2000;
+
+    // Writing 5 to clear_refs resets the peak resident set size of the
+    // process to the current one, so the peak of every stage is measured
+    // separately. Without it the peak of the whole run so far is reported.
+    // Memory freed by earlier stages is given back first, or it stays resident.
+    void ResetPeakMemory()
+    {
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+    }
+
+    size_t GetPeakMemoryKB()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.rfind("VmHWM:", 0) == 0)
+                return std::stoull(line.substr(line.find_first_of("0123456789")));
+        }
+
+        rusage usage = {};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss);
+    }
+
+    // One line of key=value pairs per stage, so results can be both read
+    // and parsed. States per second count the bigger of the input and the
+    // output, which is the work done by the stage.
+    void Report(const char *stage, const std::string &name, size_t input_states, size_t output_states,
+                double seconds, size_t peak_memory, const std::string &details = "")
+    {
+        std::cout << "    stage=" << stage << " automaton=" << name << " input_states=" << input_states
+                  << " output_states=" << output_states << " seconds=" << seconds
+                  << " states_per_second=" << static_cast<double>(std::max(input_states, output_states)) / seconds
+                  << " peak_rss_kb=" << peak_memory << details << "\n";
+    }
+
+    // Statistics of the library built with AUTOMATON_STATISTICS, for every
+    // stage including the ones called by other stages.
+    void ReportStatistics(const StageStatistics &statistics)
+    {
+        std::cout << "    statistics stage=" << statistics.stage << " seconds=" << statistics.seconds
+                  << " input_states=" << statistics.input_states << " input_transitions=" << statistics.input_transitions
+                  << " output_states=" << statistics.output_states << " output_transitions=" << statistics.output_transitions
+                  << " output_length=" << statistics.output_length
+                  << " subsets=" << statistics.subsets << " hash_probes=" << statistics.hash_probes
+                  << " refinement_rounds=" << statistics.refinement_rounds << " classes_per_round=";
+
+        for (size_t round = 0; round < statistics.classes_per_round.size(); ++round)
+            std::cout << (round == 0 ? "" : ",") << statistics.classes_per_round[round];
+
+        std::cout << " allocations=" << statistics.allocations << " allocated_bytes=" << statistics.allocated_bytes << "\n";
+    }
+
+    // Runs the stage on a copy of the input and reports it.
+    template <class stage_t>
+    Automaton Measure(const char *stage_name, const std::string &name, const Automaton &input, stage_t &&stage)
+    {
+        Automaton automaton = input;
+        ResetPeakMemory();
+
+        Benchmarks::Timer timer;
+        Automaton output = stage(automaton);
+        double seconds = timer.GetSeconds();
+
+        Report(stage_name, name, input.GetNumberOfStates(), output.GetNumberOfStates(), seconds, GetPeakMemoryKB());
+        return output;
+    }
+
+    void RunStages(const std::string &name, const Automaton &nfa)
+    {
+        using namespace AutomatonTransformer;
+
+        auto eps_free = Measure("RemoveEpsTransitions", name, nfa, [](Automaton &automaton)
+        {
+            RemoveEpsTransitions(automaton);
+            return std::move(automaton);
+        });
+
+        auto trimmed = Measure("Trim", name, eps_free, [](Automaton &automaton)
+        {
+            Trim(automaton);
+            return std::move(automaton);
+        });
+
+        auto dfa = Measure("DFAFromNFA", name, trimmed, [](Automaton &automaton) { return DFAFromNFA(automaton); });
+
+        auto cdfa = Measure("MakeDFAComplete", name, dfa, [](Automaton &automaton)
+        {
+            MakeDFAComplete(automaton);
+            return std::move(automaton);
+        });
+
+        if (cdfa.GetNumberOfStates() <= Max_moore_states)
+        {
+            Measure("MCDFAFromCDFA(Moore)", name, cdfa, [](Automaton &automaton)
+            {
+                return MCDFAFromCDFA(automaton, MinimizationAlgorithm::Moore);
+            });
+        }
+
+        auto mcdfa = Measure("MCDFAFromCDFA(Hopcroft)", name, cdfa, [](Automaton &automaton)
+        {
+            return MCDFAFromCDFA(automaton, MinimizationAlgorithm::Hopcroft);
+        });
+
+        if (mcdfa.GetNumberOfStates() > Max_regexpr_states)
+            return;
+
+        ResetPeakMemory();
+        Benchmarks::Timer timer;
+        auto expression = RegExpr(mcdfa);
+        double seconds = timer.GetSeconds();
+
+        Report("RegExpr", name, mcdfa.GetNumberOfStates(), mcdfa.GetNumberOfStates(), seconds, GetPeakMemoryKB(),
+               " expression_length=" + std::to_string(expression.size()));
+    }
+
+    // The parallel stages with 1, 2, 4, ... threads up to the hardware
+    // threads. Speedup is the time with one thread over the time with more.
+    void RunThreadSweep(const std::string &name, const Automaton &nfa)
+    {
+        using namespace AutomatonTransformer;
+
+        FlatAutomaton flat(nfa);
+        auto cdfa = CDFAFromDFA(DFAFromNFA(flat));
+
+        size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        double single_dfa_seconds = 0;
+        double single_moore_seconds = 0;
+
+        for (size_t threads = 1; ; threads = std::min(2 * threads, max_threads))
+        {
+            ResetPeakMemory();
+            Benchmarks::Timer dfa_timer;
+            auto dfa = ParallelDFAFromNFA(flat, threads);
+            double dfa_seconds = dfa_timer.GetSeconds();
+
+            if (threads == 1)
+                single_dfa_seconds = dfa_seconds;
+
+            Report("ParallelDFAFromNFA", name, flat.GetNumberOfStates(), dfa.GetNumberOfStates(), dfa_seconds,
+                   GetPeakMemoryKB(), " threads=" + std::to_string(threads) + " speedup=" + std::to_string(single_dfa_seconds / dfa_seconds));
+
+            ResetPeakMemory();
+            Benchmarks::Timer moore_timer;
+            auto minimal = ParallelMCDFAFromCDFA(cdfa, threads);
+            double moore_seconds = moore_timer.GetSeconds();
+
+            if (threads == 1)
+                single_moore_seconds = moore_seconds;
+
+            Report("ParallelMCDFAFromCDFA", name, cdfa.GetNumberOfStates(), minimal.GetNumberOfStates(), moore_seconds,
+                   GetPeakMemoryKB(), " threads=" + std::to_string(threads) + " speedup=" + std::to_string(single_moore_seconds / moore_seconds));
+
+            if (threads == max_threads)
+                break;
+        }
+    }
+};
+
+void Benchmarks::TransformerStages()
+{
+    if (AutomatonStatistics::IsEnabled())
+        AutomatonStatistics::SetCallback(ReportStatistics);
+
+    RunStages("random_nfa(20,2,2)", RandomNFA(1, 20, 2, 2, 0.2));
+    RunStages("random_nfa(32,4,1)", RandomNFA(2, 32, 4, 1, 0.05));
+    RunStages("random_dfa(200000,4)", RandomDFA(3, 200000, 4, 0.1));
+    RunStages("nth_from_end(12)", NthFromEndNFA(12));
+    RunStages("nth_from_end(18)", NthFromEndNFA(18));
+    RunStages("chain(200000,2)", ChainNFA(200000, 2));
+    RunStages("cycle(1000,3)", CycleNFA(1000, 3));
+
+    RunThreadSweep("nth_from_end(18)", NthFromEndNFA(18));
+
+    AutomatonStatistics::SetCallback(nullptr);
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../automaton_algorithms.hpp"
+#include "../streaming_matcher.hpp"
+#include "benchmarks.hpp"
+
+namespace
+{
+    const size_t Text_size = 16 << 20;
+    const size_t Chunk_size = 4096;
+    const char *Keyword = "ERROR";
+
+    // Words over the log alphabet ending with the keyword.
+    Automaton BuildKeywordNFA(std::string_view keyword)
+    {
+        std::set<Automaton::alpha_t> alphabet = {'\n'};
+        for (Automaton::alpha_t letter = ' '; letter <= '~'; ++letter)
+            alphabet.insert(letter);
+
+        Automaton automaton(alphabet, keyword.size() + 1);
+        for (auto letter : alphabet)
+            automaton.AddEdge(0, 0, letter);
+
+        for (size_t state = 0; state < keyword.size(); ++state)
+            automaton.AddEdge(state, state + 1, keyword[state]);
+
+        automaton.SetFinal(keyword.size());
+        return automaton;
+    }
+
+    std::string GenerateText(size_t size)
+    {
+        static const char *Words[] = {"INFO", "DEBUG", "WARN", "ERROR", "request", "id=42", "user", "took", "12ms", "GET", "/index.html"};
+
+        std::mt19937 generator(18);
+        std::string text;
+        text.reserve(size + 64);
+
+        while (text.size() < size)
+        {
+            text += Words[generator() % std::size(Words)];
+            text += generator() % 8 == 0 ? '\n' : ' ';
+        }
+
+        return text;
+    }
+
+    // Feeds the text in chunks of Chunk_size bytes.
+    template <class feed_t>
+    double FeedInChunks(std::string_view text, feed_t &&feed)
+    {
+        Benchmarks::Timer timer;
+        for (size_t begin = 0; begin < text.size(); begin += Chunk_size)
+        {
+            auto chunk = text.substr(begin, Chunk_size);
+            feed(std::span<const char>(chunk.data(), chunk.size()));
+        }
+
+        return timer.GetSeconds();
+    }
+
+    void Report(const char *name, size_t bytes, double seconds, size_t matches)
+    {
+        std::cout << "    " << name << ": " << static_cast<double>(bytes) / seconds / 1e6 << " MB/s, "
+                  << matches << " matches\n";
+    }
+};
+
+void Benchmarks::StreamingMatching()
+{
+    using namespace AutomatonTransformer;
+
+    auto text = GenerateText(Text_size);
+    auto nfa = BuildKeywordNFA(Keyword);
+
+    CompiledDFA dfa(MCDFAFromCDFA(CDFAFromDFA(DFAFromNFA(nfa))));
+    BitParallelNFA bit_parallel_nfa(nfa);
+
+    Timer whole_text_timer;
+    size_t accepted = dfa.Accepts(text);
+    Report("CompiledDFA::Accepts (whole text)", text.size(), whole_text_timer.GetSeconds(), accepted);
+
+    StreamingDFAMatcher state_only(dfa);
+    double seconds = FeedInChunks(text, [&](std::span<const char> chunk) { state_only.Feed(chunk); });
+    Report("StreamingDFAMatcher (state only)", text.size(), seconds, state_only.IsAccepting());
+
+    size_t dfa_matches = 0;
+    StreamingDFAMatcher dfa_matcher(dfa);
+    seconds = FeedInChunks(text, [&](std::span<const char> chunk)
+    {
+        dfa_matcher.Feed(chunk, [&](uint64_t, std::span<const uint32_t>) { ++dfa_matches; });
+    });
+    Report("StreamingDFAMatcher (every match)", text.size(), seconds, dfa_matches);
+
+    size_t nfa_matches = 0;
+    StreamingNFAMatcher nfa_matcher(bit_parallel_nfa);
+    seconds = FeedInChunks(text, [&](std::span<const char> chunk)
+    {
+        nfa_matcher.Feed(chunk, [&](uint64_t) { ++nfa_matches; });
+    });
+    Report("StreamingNFAMatcher (every match)", text.size(), seconds, nfa_matches);
+}
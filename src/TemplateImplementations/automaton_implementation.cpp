@@ -1,12 +1,13 @@
 #include <iostream>
 
 template <class alpha_t>
-GenericAutomaton<alpha_t>::GenericAutomaton(const std::set<alpha_t> &alphabet, size_t number_of_states):
-    states_(),
+GenericAutomaton<alpha_t>::GenericAutomaton(const std::set<alpha_t> &alphabet, size_t number_of_states,
+                                            std::pmr::memory_resource *resource):
+    states_(resource),
     number_of_states_(0),
     start_state_(0),
-    final_states_(),
-    existent_states_(),
+    final_states_(resource),
+    existent_states_(resource),
     alphabet_(alphabet),
     optimize_epsilons_(false)
 {
@@ -20,12 +21,13 @@ GenericAutomaton<alpha_t>::GenericAutomaton(const std::set<alpha_t> &alphabet, s
 }
 
 template <class alpha_t>
-GenericAutomaton<alpha_t>::GenericAutomaton(std::set<alpha_t> &&alphabet, size_t number_of_states):
-    states_(),
+GenericAutomaton<alpha_t>::GenericAutomaton(std::set<alpha_t> &&alphabet, size_t number_of_states,
+                                            std::pmr::memory_resource *resource):
+    states_(resource),
     number_of_states_(0),
     start_state_(0),
-    final_states_(),
-    existent_states_(),
+    final_states_(resource),
+    existent_states_(resource),
     alphabet_(std::move(alphabet)),
     optimize_epsilons_(false)
 {
@@ -38,21 +40,43 @@ GenericAutomaton<alpha_t>::GenericAutomaton(std::set<alpha_t> &&alphabet, size_t
     SetStates(number_of_states); 
 }
 
+template <class alpha_t>
+GenericAutomaton<alpha_t>::GenericAutomaton(const GenericAutomaton &other, std::pmr::memory_resource *resource):
+    states_(other.states_, resource),
+    number_of_states_(other.number_of_states_),
+    start_state_(other.start_state_),
+    final_states_(other.final_states_, resource),
+    existent_states_(other.existent_states_, resource),
+    alphabet_(other.alphabet_),
+    optimize_epsilons_(other.optimize_epsilons_)
+{}
+
+template <class alpha_t>
+GenericAutomaton<alpha_t>::GenericAutomaton(std::pmr::memory_resource *resource):
+    states_(resource),
+    number_of_states_(0),
+    start_state_(0),
+    final_states_(resource),
+    existent_states_(resource),
+    alphabet_(),
+    optimize_epsilons_(false)
+{}
+
 template <class alpha_type>
 template <class other_alpha>
 GenericAutomaton<alpha_type>::GenericAutomaton(const GenericAutomaton<other_alpha> &other):
-    states_(),
+    states_(other.GetMemoryResource()),
     number_of_states_(other.number_of_states_),
     start_state_(other.start_state_),
-    final_states_(other.final_states_),
-    existent_states_(other.existent_states_),
+    final_states_(other.final_states_, other.GetMemoryResource()),
+    existent_states_(other.existent_states_, other.GetMemoryResource()),
     alphabet_(),
     optimize_epsilons_(false)
 {
     for (auto &old_state : other.states_)
     {
-        state_t new_state = {};
-        for (auto alpha_neigh : other.GetNeighbours(old_state.first))
+        state_t new_state(other.GetMemoryResource());
+        for (auto &alpha_neigh : other.GetNeighbours(old_state.first))
         {
             if constexpr (std::is_same_v<alpha_type, std::string>)
                 new_state[std::isalpha(alpha_neigh.first)
@@ -62,7 +86,7 @@ GenericAutomaton<alpha_type>::GenericAutomaton(const GenericAutomaton<other_alph
             else
                 new_state[static_cast<alpha_type>(alpha_neigh.first)] = alpha_neigh.second;
         }
-        states_.insert({old_state.first, new_state});
+        states_.emplace(old_state.first, std::move(new_state));
     }
 
     for (auto alpha : other.alphabet_)
@@ -80,7 +104,7 @@ GenericAutomaton<alpha_type>::GenericAutomaton(const GenericAutomaton<other_alph
 template <class alpha_t>
 Automaton GenericAutomaton<alpha_t>::buildFromAnother(const Automaton &GenericAutomaton, bool optimize_epsilons)
 {
-    Automaton result;
+    Automaton result(GenericAutomaton.GetMemoryResource());
     result.SetAlphabet(GenericAutomaton.alphabet_);
     result.SetOptimizeEpsilonsFlag(optimize_epsilons);
 
@@ -133,7 +157,7 @@ size_t GenericAutomaton<alpha_t>::AddState(size_t state_number)
     }
 
     existent_states_.insert(state_number);
-    states_[state_number] = state_t();
+    states_[state_number].clear();
     ++number_of_states_;
 
     return state_number;
@@ -195,9 +219,6 @@ bool GenericAutomaton<alpha_t>::AddEdge(size_t from, size_t to, alpha_t alpha)
 
     state_t& state_from = states_[from];
 
-    if (!state_from.contains(alpha))
-        state_from[alpha] = {};
-
     state_from[alpha].insert(to);
 
     return true;
@@ -244,7 +265,7 @@ bool GenericAutomaton<alpha_t>::CanTransit(size_t state, alpha_t alpha) const
 }
 
 template <class alpha_t>
-const std::unordered_map<alpha_t, std::set<size_t>>& GenericAutomaton<alpha_t>::GetNeighbours(size_t vertex_number) const
+const typename GenericAutomaton<alpha_t>::state_t& GenericAutomaton<alpha_t>::GetNeighbours(size_t vertex_number) const
 {
     return states_.at(vertex_number);
 }
@@ -271,13 +292,13 @@ bool GenericAutomaton<alpha_t>::IsStateFinal(size_t state) const
 }
 
 template <class alpha_t>
-const std::set<size_t>& GenericAutomaton<alpha_t>::GetFinalStates() const
+const std::pmr::set<size_t>& GenericAutomaton<alpha_t>::GetFinalStates() const
 {
     return final_states_;
 }
 
 template <class alpha_t>
-const std::set<size_t>& GenericAutomaton<alpha_t>::GetStateNumbers() const { return existent_states_; }
+const std::pmr::set<size_t>& GenericAutomaton<alpha_t>::GetStateNumbers() const { return existent_states_; }
 
 template <class alpha_t>
 void GenericAutomaton<alpha_t>::SetOptimizeEpsilonsFlag(bool optimize_epsilons)
@@ -295,4 +316,10 @@ template <class alpha_t>
 void GenericAutomaton<alpha_t>::SetAlphabet(const std::set<GenericAutomaton::alpha_t>& alphabet) { alphabet_ = alphabet; }
 
 template <class alpha_t>
-const std::set<alpha_t>& GenericAutomaton<alpha_t>::GetAlphabet() const { return alphabet_; }
\ No newline at end of file
+const std::set<alpha_t>& GenericAutomaton<alpha_t>::GetAlphabet() const { return alphabet_; }
+
+template <class alpha_t>
+std::pmr::memory_resource* GenericAutomaton<alpha_t>::GetMemoryResource() const
+{
+    return states_.get_allocator().resource();
+}
\ No newline at end of file
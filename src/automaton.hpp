@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <limits>
+#include <memory_resource>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -17,12 +18,23 @@ class GenericAutomaton
 {
     public:
         using alpha_t = alpha_type;
-        using state_t = std::unordered_map<alpha_t, std::set<size_t>>;
+        using state_t = std::pmr::unordered_map<alpha_t, std::pmr::set<size_t>>;
 
         static const alpha_t Epsilon;
 
-        GenericAutomaton(const std::set<alpha_t> &alphabet, size_t number_of_states = 1);
-        GenericAutomaton(std::set<alpha_t> &&alphabet, size_t number_of_states = 1);
+        // All containers of the automaton allocate from the memory resource, so
+        // large intermediate automata can be built in an arena or a pool.
+        GenericAutomaton(const std::set<alpha_t> &alphabet, size_t number_of_states = 1,
+                         std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+        GenericAutomaton(std::set<alpha_t> &&alphabet, size_t number_of_states = 1,
+                         std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+        GenericAutomaton(const GenericAutomaton &other) = default;
+        GenericAutomaton(const GenericAutomaton &other, std::pmr::memory_resource *resource);
+        GenericAutomaton(GenericAutomaton &&other) = default;
+
+        GenericAutomaton& operator=(const GenericAutomaton &other) = default;
+        GenericAutomaton& operator=(GenericAutomaton &&other) = default;
 
         template <class other_alpha>
         GenericAutomaton(const GenericAutomaton<other_alpha> &other);
@@ -41,40 +53,42 @@ class GenericAutomaton
 
         bool CanTransit(size_t state, alpha_t alpha) const;
 
-        const std::unordered_map<alpha_t, std::set<size_t>>& GetNeighbours(size_t vertex_number) const;
+        const state_t& GetNeighbours(size_t vertex_number) const;
 
         void SetStartState(size_t start_state);
         size_t GetStartState() const;
 
         void SetFinal(size_t state, bool is_final = true);
         bool IsStateFinal(size_t state) const;
-        const std::set<size_t>& GetFinalStates() const;
+        const std::pmr::set<size_t>& GetFinalStates() const;
 
         void SetOptimizeEpsilonsFlag(bool optimize_epsilons);
         bool GetOptimizeEpsilonsFlag();
 
-        const std::set<size_t>& GetStateNumbers() const;
+        const std::pmr::set<size_t>& GetStateNumbers() const;
 
         void AddCharToAlphabet(alpha_t alpha);
         void SetAlphabet(const std::set<alpha_t>& alphabet);
         const std::set<alpha_t>& GetAlphabet() const;
 
+        std::pmr::memory_resource* GetMemoryResource() const;
+
         template <class> friend class GenericAutomaton;
 
     private:
-        std::unordered_map<size_t, state_t> states_;
+        std::pmr::unordered_map<size_t, state_t> states_;
         size_t number_of_states_ = 0;
 
         size_t start_state_ = 0;
-        std::set<size_t> final_states_;
+        std::pmr::set<size_t> final_states_;
 
-        std::set<size_t> existent_states_;
+        std::pmr::set<size_t> existent_states_;
 
         std::set<alpha_t> alphabet_;
 
         bool optimize_epsilons_ = false;
 
-        GenericAutomaton() = default;
+        explicit GenericAutomaton(std::pmr::memory_resource *resource);
 };
 
 #include "automaton_implementation.cpp"
\ No newline at end of file
@@ -1,15 +1,410 @@
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <queue>
 #include <vector>
 
 #include "automaton_algorithms.hpp"
+#include "automaton_statistics.hpp"
+#include "regular_expression.hpp"
+#include "subset_table.hpp"
 
+namespace
+{
+    // Letters of every class, keyed by the smallest one.
+    std::map<Automaton::alpha_t, std::vector<Automaton::alpha_t>> GetClassLetters(const AutomatonTransformer::AlphabetClasses &classes)
+    {
+        std::map<Automaton::alpha_t, std::vector<Automaton::alpha_t>> class_letters;
+        for (auto [letter, first_letter] : classes)
+            class_letters[first_letter].push_back(letter);
+
+        return class_letters;
+    }
+
+    // Copy of the states of the automaton with the edges given by add_edges(state, copy).
+    template <class add_edges_t>
+    Automaton CopyStates(const Automaton &automaton, std::set<Automaton::alpha_t> &&alphabet, add_edges_t &&add_edges)
+    {
+        Automaton result(std::move(alphabet), 1, automaton.GetMemoryResource());
+        result.SetStates(0);
+
+        for (auto state : automaton.GetStateNumbers())
+            result.AddState(state);
+
+        result.SetStartState(automaton.GetStartState());
+        for (auto state : automaton.GetStateNumbers())
+        {
+            result.SetFinal(state, automaton.IsStateFinal(state));
+            add_edges(state, result);
+        }
+
+        return result;
+    }
+
+    // Copy of the states with keep[flat state] set and the edges between them,
+    // numbered as in the automaton.
+    Automaton KeepStates(const Automaton &automaton, const FlatAutomaton &flat, const std::vector<uint8_t> &keep)
+    {
+        Automaton result(automaton.GetAlphabet(), 1, automaton.GetMemoryResource());
+        result.SetStates(0);
+
+        for (FlatAutomaton::state_t state = 0; state < flat.GetNumberOfStates(); ++state)
+        {
+            if (keep[state])
+                result.AddState(flat.GetOriginalState(state));
+        }
+
+        result.SetStartState(automaton.GetStartState());
+        for (FlatAutomaton::state_t state = 0; state < flat.GetNumberOfStates(); ++state)
+        {
+            if (!keep[state])
+                continue;
+
+            size_t original_state = flat.GetOriginalState(state);
+            result.SetFinal(original_state, flat.IsStateFinal(state));
+
+            auto symbols = flat.GetSymbols(state);
+            auto targets = flat.GetTargets(state);
+            for (size_t edge = 0; edge < targets.size(); ++edge)
+            {
+                if (!keep[targets[edge]])
+                    continue;
+
+                auto alpha = symbols[edge] == flat.GetEpsilonSymbol() ? Automaton::Epsilon : flat.GetAlphabet()[symbols[edge]];
+                result.AddEdge(original_state, flat.GetOriginalState(targets[edge]), alpha);
+            }
+        }
+
+        return result;
+    }
+
+    AutomatonTransformer::AlphabetClasses GetClassesOfLetters(const FlatAutomaton &flat)
+    {
+        std::vector<uint32_t> symbol_classes;
+        std::vector<Automaton::alpha_t> first_letters(flat.GetSymbolClasses(symbol_classes), Automaton::Epsilon);
+
+        AutomatonTransformer::AlphabetClasses classes;
+        for (size_t symbol = 0; symbol < symbol_classes.size(); ++symbol)
+        {
+            auto letter = flat.GetAlphabet()[symbol];
+            auto &first_letter = first_letters[symbol_classes[symbol]];
+
+            // Epsilon is never merged with letters.
+            if (letter == Automaton::Epsilon)
+            {
+                classes[letter] = letter;
+                continue;
+            }
+
+            if (first_letter == Automaton::Epsilon)
+                first_letter = letter;
+
+            classes[letter] = first_letter;
+        }
+
+        return classes;
+    }
+
+    Automaton DeterminizeTrimmed(const Automaton &automaton, const FlatAutomaton &flat)
+    {
+        Automaton DFA(automaton.GetAlphabet(), 1, automaton.GetMemoryResource());
+
+        size_t start_state = automaton.GetStartState();
+        SubsetTable subsets;
+        subsets.Insert(std::vector<size_t>{start_state}, automaton.IsStateFinal(start_state));
+        DFA.SetFinal(0, subsets.IsFinal(0));
+
+        std::vector<size_t> old_state;
+        std::vector<size_t> new_state;
+
+        // Equivalent letters lead to the same subset, so it is computed once for
+        // the smallest letter of every class and states are numbered as without
+        // classes.
+        auto class_letters = GetClassLetters(GetClassesOfLetters(flat));
+
+        // Subsets are numbered in the order they are discovered, so walking the
+        // table by index is the same BFS as walking a queue of new states.
+        for (size_t state = 0; state < subsets.Size(); ++state)
+        {
+            auto subset = subsets.GetSubset(state);
+            old_state.assign(subset.begin(), subset.end());
+
+            for (auto &[alpha, letters] : class_letters)
+            {
+                new_state.clear();
+                for (auto state_in_new_state : old_state)
+                {
+                    auto &letters_transitions = automaton.GetNeighbours(state_in_new_state);
+                    auto transition = letters_transitions.find(alpha);
+                    if (transition == letters_transitions.end())
+                        continue;
+
+                    new_state.insert(new_state.end(), transition->second.begin(), transition->second.end());
+                }
+
+                if (new_state.empty())
+                    continue;
+
+                std::sort(new_state.begin(), new_state.end());
+                new_state.erase(std::unique(new_state.begin(), new_state.end()), new_state.end());
+
+                uint64_t hash = SubsetTable::Hash(new_state);
+                size_t target = subsets.Find(new_state, hash);
+
+                if (target == SubsetTable::NotFound)
+                {
+                    bool is_final = std::any_of(new_state.begin(), new_state.end(),
+                                                [&automaton](size_t neighbour) { return automaton.IsStateFinal(neighbour); });
+
+                    target = subsets.Insert(new_state, hash, is_final);
+                    DFA.AddState(target);
+                    DFA.SetFinal(target, subsets.IsFinal(target));
+                }
+
+                for (auto letter : letters)
+                    DFA.AddEdge(state, target, letter);
+            }
+        }
+
+        return DFA;
+    }
+
+    const uint32_t Unvisited = std::numeric_limits<uint32_t>::max();
+
+    // Strongly connected components of the epsilon edges in CSR form. Tarjan's
+    // algorithm finishes a component after every component it reaches, so
+    // components are numbered in reverse topological order.
+    struct EpsilonComponents
+    {
+        std::vector<uint32_t> component_of;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> states;
+
+        size_t Size() const { return offsets.size() - 1; }
+
+        std::span<const uint32_t> GetStates(size_t component) const
+        {
+            return {states.data() + offsets[component], offsets[component + 1] - offsets[component]};
+        }
+    };
+
+    EpsilonComponents FindEpsilonComponents(const FlatAutomaton &automaton)
+    {
+        size_t number_of_states = automaton.GetNumberOfStates();
+        auto epsilon = automaton.GetEpsilonSymbol();
+
+        EpsilonComponents components = {std::vector<uint32_t>(number_of_states, Unvisited), {0}, {}};
+
+        std::vector<uint32_t> order(number_of_states, Unvisited);
+        std::vector<uint32_t> low_link(number_of_states, 0);
+        std::vector<uint32_t> tarjan_stack;
+        std::vector<std::pair<uint32_t, size_t>> call_stack;
+        uint32_t next_order = 0;
+
+        for (uint32_t root = 0; root < number_of_states; ++root)
+        {
+            if (order[root] != Unvisited)
+                continue;
+
+            call_stack.push_back({root, 0});
+            order[root] = low_link[root] = next_order++;
+            tarjan_stack.push_back(root);
+
+            while (!call_stack.empty())
+            {
+                auto &[state, next_edge] = call_stack.back();
+                auto targets = automaton.GetTargets(state, epsilon);
+
+                if (next_edge < targets.size())
+                {
+                    uint32_t target = targets[next_edge++];
+                    if (order[target] == Unvisited)
+                    {
+                        order[target] = low_link[target] = next_order++;
+                        tarjan_stack.push_back(target);
+                        call_stack.push_back({target, 0});
+                    }
+                    else if (components.component_of[target] == Unvisited)
+                    {
+                        low_link[state] = std::min(low_link[state], order[target]);
+                    }
+
+                    continue;
+                }
+
+                uint32_t finished = state;
+                call_stack.pop_back();
+
+                if (!call_stack.empty())
+                    low_link[call_stack.back().first] = std::min(low_link[call_stack.back().first], low_link[finished]);
+
+                if (low_link[finished] != order[finished])
+                    continue;
+
+                auto component = static_cast<uint32_t>(components.Size());
+                uint32_t member = Unvisited;
+                do
+                {
+                    member = tarjan_stack.back();
+                    tarjan_stack.pop_back();
+
+                    components.component_of[member] = component;
+                    components.states.push_back(member);
+                } while (member != finished);
+
+                components.offsets.push_back(static_cast<uint32_t>(components.states.size()));
+            }
+        }
+
+        return components;
+    }
+
+    // Automaton whose edges are labelled with regular expressions. Every state
+    // keeps its labelled successors and its predecessors, so eliminating a
+    // state only touches its neighbours.
+    class GeneralizedAutomaton
+    {
+        public:
+            using node_t = RegularExpressionPool::node_t;
+
+            explicit GeneralizedAutomaton(size_t number_of_states):
+                successors_(number_of_states),
+                predecessors_(number_of_states)
+            {}
+
+            void AddEdge(uint32_t from, uint32_t to, node_t label, RegularExpressionPool &pool)
+            {
+                auto [edge, is_new] = successors_[from].try_emplace(to, label);
+                if (is_new)
+                    predecessors_[to].insert(from);
+                else
+                    edge->second = pool.MakeUnion(edge->second, label);
+            }
+
+            node_t GetLabel(uint32_t from, uint32_t to) const
+            {
+                auto edge = successors_[from].find(to);
+                return edge == successors_[from].end() ? RegularExpressionPool::EmptySet : edge->second;
+            }
+
+            uint64_t GetEliminationCost(uint32_t state) const
+            {
+                uint64_t in_degree = predecessors_[state].size() - predecessors_[state].contains(state);
+                uint64_t out_degree = successors_[state].size() - successors_[state].contains(state);
+
+                return in_degree * out_degree;
+            }
+
+            // Replaces the paths through the state by edges between its
+            // neighbours, which are returned.
+            void Eliminate(uint32_t state, RegularExpressionPool &pool, std::vector<uint32_t> &neighbours)
+            {
+                auto loop = pool.MakeStar(GetLabel(state, state));
+                successors_[state].erase(state);
+                predecessors_[state].erase(state);
+
+                neighbours.clear();
+                for (auto predecessor : predecessors_[state])
+                {
+                    auto prefix = pool.MakeConcatenation(successors_[predecessor].at(state), loop);
+                    successors_[predecessor].erase(state);
+
+                    for (auto &[successor, label] : successors_[state])
+                        AddEdge(predecessor, successor, pool.MakeConcatenation(prefix, label), pool);
+
+                    neighbours.push_back(predecessor);
+                }
+
+                for (auto &successor_label : successors_[state])
+                {
+                    predecessors_[successor_label.first].erase(state);
+                    neighbours.push_back(successor_label.first);
+                }
+
+                successors_[state].clear();
+                predecessors_[state].clear();
+            }
+
+        private:
+            std::vector<std::map<uint32_t, node_t>> successors_;
+            std::vector<std::set<uint32_t>> predecessors_;
+    };
+};
+
+// Epsilon closures are computed once per component of the epsilon graph, from
+// the closures of the components it reaches, and kept as lists of components.
+// Then every state takes the letter edges and finality of its closure.
 void AutomatonTransformer::RemoveEpsTransitions(Automaton &automaton)
 {
-    bool old_flag = automaton.GetOptimizeEpsilonsFlag();
-    automaton = Automaton::buildFromAnother(automaton, true);
-    automaton.SetOptimizeEpsilonsFlag(old_flag);
+    AUTOMATON_STAGE("RemoveEpsTransitions");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    FlatAutomaton flat(automaton);
+    auto components = FindEpsilonComponents(flat);
+    auto epsilon = flat.GetEpsilonSymbol();
+
+    std::vector<uint32_t> closure_offsets = {0};
+    std::vector<uint32_t> closures;
+    std::vector<uint32_t> visit_marks(components.Size(), Unvisited);
+
+    for (uint32_t component = 0; component < components.Size(); ++component)
+    {
+        visit_marks[component] = component;
+        closures.push_back(component);
+
+        for (auto state : components.GetStates(component))
+        {
+            for (auto target : flat.GetTargets(state, epsilon))
+            {
+                uint32_t reached = components.component_of[target];
+                if (visit_marks[reached] == component)
+                    continue;
+
+                for (uint32_t index = closure_offsets[reached]; index < closure_offsets[reached + 1]; ++index)
+                {
+                    uint32_t closure_component = closures[index];
+                    if (visit_marks[closure_component] == component)
+                        continue;
+
+                    visit_marks[closure_component] = component;
+                    closures.push_back(closure_component);
+                }
+            }
+        }
+
+        closure_offsets.push_back(static_cast<uint32_t>(closures.size()));
+    }
+
+    Automaton result(automaton.GetAlphabet(), 1, automaton.GetMemoryResource());
+    result.SetStates(0);
+    for (auto state : automaton.GetStateNumbers())
+        result.AddState(state);
+
+    result.SetStartState(automaton.GetStartState());
+    result.SetOptimizeEpsilonsFlag(automaton.GetOptimizeEpsilonsFlag());
+
+    for (FlatAutomaton::state_t state = 0; state < flat.GetNumberOfStates(); ++state)
+    {
+        size_t original_state = flat.GetOriginalState(state);
+        uint32_t component = components.component_of[state];
+
+        for (uint32_t index = closure_offsets[component]; index < closure_offsets[component + 1]; ++index)
+        {
+            for (auto closure_state : components.GetStates(closures[index]))
+            {
+                if (flat.IsStateFinal(closure_state))
+                    result.SetFinal(original_state);
+
+                auto symbols = flat.GetSymbols(closure_state);
+                auto targets = flat.GetTargets(closure_state);
+                for (size_t edge = 0; edge < targets.size() && symbols[edge] != epsilon; ++edge)
+                    result.AddEdge(original_state, flat.GetOriginalState(targets[edge]), flat.GetAlphabet()[symbols[edge]]);
+            }
+        }
+    }
+
+    automaton = std::move(result);
+    AUTOMATON_STAGE_OUTPUT(automaton);
 }
 
 void AutomatonTransformer::InverseCDFA(Automaton &automaton)
@@ -20,6 +415,9 @@ void AutomatonTransformer::InverseCDFA(Automaton &automaton)
 
 void AutomatonTransformer::MakeDFAComplete(Automaton &automaton)
 {
+    AUTOMATON_STAGE("MakeDFAComplete");
+    AUTOMATON_STAGE_INPUT(automaton);
+
     bool need_garbage = true;
     size_t garbage_state = 0;
 
@@ -43,84 +441,186 @@ void AutomatonTransformer::MakeDFAComplete(Automaton &automaton)
     if (need_garbage == false)
         for (auto alpha : automaton.GetAlphabet())
             automaton.AddEdge(garbage_state, garbage_state, alpha);
+
+    AUTOMATON_STAGE_OUTPUT(automaton);
+}
+
+void AutomatonTransformer::Trim(Automaton &automaton)
+{
+    AUTOMATON_STAGE("Trim");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    FlatAutomaton flat(automaton);
+    std::vector<uint8_t> useful;
+    if (GetUsefulStates(flat, useful) < flat.GetNumberOfStates())
+    {
+        bool optimize_epsilons = automaton.GetOptimizeEpsilonsFlag();
+        automaton = KeepStates(automaton, flat, useful);
+        automaton.SetOptimizeEpsilonsFlag(optimize_epsilons);
+    }
+
+    AUTOMATON_STAGE_OUTPUT(automaton);
 }
 
 Automaton AutomatonTransformer::DFAFromNFA(const Automaton &automaton)
 {
-    Automaton DFA(automaton.GetAlphabet());
-    DFA.SetFinal(0, automaton.IsStateFinal(0));
+    AUTOMATON_STAGE("DFAFromNFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    // Subsets of states that can't reach a final state lead nowhere, so the
+    // subsets are built over the trimmed automaton.
+    FlatAutomaton flat(automaton);
+    std::vector<uint8_t> useful;
+    if (GetUsefulStates(flat, useful) < flat.GetNumberOfStates())
+    {
+        auto trimmed = KeepStates(automaton, flat, useful);
+        auto DFA = DeterminizeTrimmed(trimmed, FlatAutomaton(trimmed));
+        AUTOMATON_STAGE_OUTPUT(DFA);
+        return DFA;
+    }
+
+    auto DFA = DeterminizeTrimmed(automaton, flat);
+    AUTOMATON_STAGE_OUTPUT(DFA);
+    return DFA;
+}
+
+Automaton AutomatonTransformer::Reverse(const Automaton &automaton)
+{
+    AUTOMATON_STAGE("Reverse");
+    AUTOMATON_STAGE_INPUT(automaton);
 
-    size_t cur_max_index = 0;
+    FlatAutomaton flat(automaton);
 
-    std::unordered_map<std::set<size_t>, size_t, decltype([](const std::set<size_t> &) { return 0; })> new_indices;
-    new_indices.insert({{0}, cur_max_index++});
-    std::vector<std::set<size_t>> old_indices = {{0}};
+    Automaton reversed(automaton.GetAlphabet(), 1, automaton.GetMemoryResource());
+    reversed.SetStates(0);
+    for (auto state : automaton.GetStateNumbers())
+        reversed.AddState(state);
 
-    std::queue<size_t> states_queue;
-    states_queue.push(0);
+    size_t start_state = reversed.AddState();
+    reversed.SetStartState(start_state);
+    reversed.SetFinal(start_state, automaton.IsStateFinal(automaton.GetStartState()));
+    reversed.SetFinal(automaton.GetStartState());
 
-    while (!states_queue.empty())
+    for (FlatAutomaton::state_t state = 0; state < flat.GetNumberOfStates(); ++state)
     {
-        size_t state = states_queue.front();
-        states_queue.pop();
-        for (auto alpha : automaton.GetAlphabet())
+        size_t original_state = flat.GetOriginalState(state);
+
+        auto symbols = flat.GetSymbols(state);
+        auto targets = flat.GetTargets(state);
+        for (size_t edge = 0; edge < targets.size(); ++edge)
         {
-            std::set<size_t> new_state = {};
-            bool is_final = false;
-            for (auto &state_in_new_state : old_indices[state])
-            {
-                auto &letters_transitions = automaton.GetNeighbours(state_in_new_state);
-                if (!letters_transitions.contains(alpha))
-                    continue;
+            auto alpha = symbols[edge] == flat.GetEpsilonSymbol() ? Automaton::Epsilon : flat.GetAlphabet()[symbols[edge]];
+            reversed.AddEdge(flat.GetOriginalState(targets[edge]), original_state, alpha);
 
-                for (auto neighbour : automaton.GetNeighbours(state_in_new_state).at(alpha))
-                {
-                    new_state.insert(neighbour);
-                    is_final = is_final || automaton.IsStateFinal(neighbour);
-                }
-            }
+            if (flat.IsStateFinal(targets[edge]))
+                reversed.AddEdge(start_state, original_state, alpha);
+        }
+    }
 
-            if (new_state.empty())
-                continue;
+    AUTOMATON_STAGE_OUTPUT(reversed);
+    return reversed;
+}
 
-            if (!new_indices.contains(new_state))
-            {
-                new_indices.insert({new_state, cur_max_index});
-                old_indices.push_back(new_state);
-                DFA.AddState(cur_max_index);
-                DFA.SetFinal(cur_max_index, is_final);
-                DFA.AddEdge(state, cur_max_index, alpha);
-
-                states_queue.push(cur_max_index);
-                ++cur_max_index;
-            }
-            else
-            {
-                size_t target = new_indices.at(new_state);
-                DFA.AddEdge(state, target, alpha);
-            }
-        }
+Automaton AutomatonTransformer::MCDFAFromNFA(const Automaton &automaton)
+{
+    AUTOMATON_STAGE("MCDFAFromNFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    // Epsilon edges stay epsilon edges in the reversal, and DFAFromNFA
+    // doesn't follow them.
+    auto reversed = Reverse(automaton);
+    RemoveEpsTransitions(reversed);
+
+    auto DFA = DFAFromNFA(Reverse(DFAFromNFA(reversed)));
+
+    // The DFA of the empty language is a single dead state, which completion
+    // would give a second one.
+    if (DFA.GetFinalStates().empty())
+    {
+        auto MDFA = MCDFAFromCDFA(CDFAFromDFA(DFA));
+        AUTOMATON_STAGE_OUTPUT(MDFA);
+        return MDFA;
     }
 
-    return DFA;
+    // The new start state of the reversal makes a subset of its own, which
+    // behaves as the set of the final states. If that subset was reached too,
+    // it has the same row and is the only state equivalent to the start state.
+    // Nothing leads to the start state, so it is just dropped.
+    DenseDFA dense(DFA);
+    auto start_state = dense.GetStartState();
+    auto start_row = dense.GetRow(start_state);
+
+    for (DenseDFA::state_t state = 0; state < dense.GetNumberOfStates(); ++state)
+    {
+        auto row = dense.GetRow(state);
+        if (state == start_state || dense.IsStateFinal(state) != dense.IsStateFinal(start_state) ||
+            !std::equal(row.begin(), row.end(), start_row.begin(), start_row.end()))
+            continue;
+
+        std::vector<uint8_t> keep(dense.GetNumberOfStates(), true);
+        keep[start_state] = false;
+
+        dense.SetStartState(state);
+        dense = RestrictDFA(dense, keep);
+        break;
+    }
+
+    MakeDFAComplete(dense);
+    auto MDFA = dense.ToAutomaton(automaton.GetMemoryResource());
+
+    AUTOMATON_STAGE_OUTPUT(MDFA);
+    return MDFA;
 }
 
 Automaton AutomatonTransformer::CDFAFromDFA(const Automaton &automaton)
 {
-    Automaton result = automaton;
+    AUTOMATON_STAGE("CDFAFromDFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    Automaton result(automaton, automaton.GetMemoryResource());
     MakeDFAComplete(result);
+
+    AUTOMATON_STAGE_OUTPUT(result);
     return result;
 }
 
 Automaton AutomatonTransformer::ComplementOfCDFA(const Automaton &automaton)
 {
-    Automaton result = automaton;
+    Automaton result(automaton, automaton.GetMemoryResource());
     InverseCDFA(result);
     return result;
 }
 
-Automaton AutomatonTransformer::MCDFAFromCDFA(const Automaton &automaton)
+Automaton AutomatonTransformer::MCDFAFromCDFA(const Automaton &automaton, MinimizationAlgorithm algorithm)
 {
+    AUTOMATON_STAGE("MCDFAFromCDFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    if (algorithm != MinimizationAlgorithm::Moore)
+    {
+        auto MDFA = MCDFAFromCDFA(DenseDFA(automaton), algorithm).ToAutomaton(automaton.GetMemoryResource());
+        AUTOMATON_STAGE_OUTPUT(MDFA);
+        return MDFA;
+    }
+
+    auto classes = GetAlphabetClasses(automaton);
+    if (GetClassLetters(classes).size() < automaton.GetAlphabet().size())
+    {
+        auto MDFA = ExpandAlphabet(MCDFAFromCDFA(CompressAlphabet(automaton, classes), algorithm), classes);
+        AUTOMATON_STAGE_OUTPUT(MDFA);
+        return MDFA;
+    }
+
+    // Unreachable states would stay in the result as classes of their own.
+    FlatAutomaton flat(automaton);
+    std::vector<uint8_t> reachable;
+    if (GetReachableStates(flat, reachable) < flat.GetNumberOfStates())
+    {
+        auto MDFA = MCDFAFromCDFA(KeepStates(automaton, flat, reachable), algorithm);
+        AUTOMATON_STAGE_OUTPUT(MDFA);
+        return MDFA;
+    }
+
     std::unordered_map<size_t, size_t> to_vertex_order;
     std::vector<size_t> to_vertex_number(automaton.GetNumberOfStates(), std::numeric_limits<size_t>::max());
 
@@ -144,7 +644,6 @@ Automaton AutomatonTransformer::MCDFAFromCDFA(const Automaton &automaton)
 
     while (cur_classes != old_number_of_classes)
     {
-        // std::cout << "Start new step.\n";
         old_number_of_classes = cur_classes;
 
         for (size_t i = 0; i < number_of_states; ++i)
@@ -152,23 +651,14 @@ Automaton AutomatonTransformer::MCDFAFromCDFA(const Automaton &automaton)
             size_t alpha_num = 1;
             for (auto alpha : automaton.GetAlphabet())
             {
-                factor_set[i][alpha_num] = factor_set[*(automaton.GetNeighbours(to_vertex_number[i]).at(alpha).begin())][0];
+                factor_set[i][alpha_num] = factor_set[to_vertex_order[*(automaton.GetNeighbours(to_vertex_number[i]).at(alpha).begin())]][0];
                 ++alpha_num;
             }
         }
 
-        // for (size_t vertex = 0; vertex < number_of_states; ++vertex)
-        // {
-        //     for (size_t i = 0; i <= automaton.GetAlphabet().size(); ++i)
-        //         std::cout << factor_set[vertex][i] << " ";
-        //     std::cout << "\n";
-        // }
-        // std::cout << "\n";
-
         cur_classes = 0;
         new_classes.resize(number_of_states, std::numeric_limits<size_t>::max());
 
-        // std::cout << "NEW CLASSES:\n";
         for (size_t current_state = 0; current_state < factor_set.size(); ++current_state)
         {
             bool new_class = true;
@@ -182,10 +672,7 @@ Automaton AutomatonTransformer::MCDFAFromCDFA(const Automaton &automaton)
             }
 
             if (new_class)
-            {
-                // std::cout << current_state << "\n";
                 new_classes[current_state] = cur_classes++;
-            }
         }
 
         for (size_t i = 0; i < number_of_states; ++i)
@@ -193,11 +680,12 @@ Automaton AutomatonTransformer::MCDFAFromCDFA(const Automaton &automaton)
             factor_set[i].resize(automaton.GetAlphabet().size() + 1, std::numeric_limits<size_t>::max());
             factor_set[i][0] = new_classes[i];
         }
-        // std::cout << "Number of classes = " << cur_classes << '\n';
-        // std::cout << "Old number of classes = " << old_number_of_classes << '\n';
+
+        AUTOMATON_COUNT(RefinementRounds, 1);
+        AUTOMATON_CLASSES(cur_classes);
     }
 
-    Automaton MDFA(automaton.GetAlphabet(), cur_classes);
+    Automaton MDFA(automaton.GetAlphabet(), cur_classes, automaton.GetMemoryResource());
     MDFA.SetStartState(new_classes[to_vertex_order[automaton.GetStartState()]]);
 
     for (auto final : automaton.GetFinalStates())
@@ -214,240 +702,138 @@ Automaton AutomatonTransformer::MCDFAFromCDFA(const Automaton &automaton)
         }
     }
 
+    AUTOMATON_STAGE_OUTPUT(MDFA);
     return MDFA;
 }
 
-std::string AutomatonTransformer::RegExpr(const Automaton &automaton)
+AutomatonTransformer::AlphabetClasses AutomatonTransformer::GetAlphabetClasses(const Automaton &automaton)
 {
-    static const char *EmptyLanguage = "[Empty language]";
-
-    auto &finals = automaton.GetFinalStates();
-    if (finals.size() == 0)
-        return EmptyLanguage;
-
-    RegularAutomaton regauto = automaton;
-    auto new_final = regauto.AddState();
-    regauto.SetFinal(new_final);
+    return GetClassesOfLetters(FlatAutomaton(automaton));
+}
 
-    for (auto final : automaton.GetFinalStates())
+Automaton AutomatonTransformer::CompressAlphabet(const Automaton &automaton, const AlphabetClasses &classes)
+{
+    std::set<Automaton::alpha_t> alphabet;
+    for (auto letter : automaton.GetAlphabet())
     {
-        regauto.AddEdge(final, new_final, RegularAutomaton::Epsilon);
-        regauto.SetFinal(final, false);
+        auto first_letter = classes.find(letter);
+        alphabet.insert(first_letter != classes.end() ? first_letter->second : letter);
     }
 
-    for (auto state : regauto.GetStateNumbers())
+    return CopyStates(automaton, std::move(alphabet), [&](size_t state, Automaton &result)
     {
-        std::map<size_t, RegularAutomaton::alpha_t> transitions;
-        for (auto &alpha_neigh : regauto.GetNeighbours(state))
+        for (auto &[alpha, neighbours] : automaton.GetNeighbours(state))
         {
-            auto &alpha = alpha_neigh.first;
-
-            std::set<size_t> neighbours = {};
-            for (auto neigh : alpha_neigh.second)
-            {
-                if (transitions.contains(neigh))
-                    transitions[neigh] += std::string(" + ") + alpha;
-                else
-                    transitions[neigh] = alpha;
-
-                neighbours.insert(neigh);
-            }
+            auto first_letter = classes.find(alpha);
+            if (first_letter != classes.end() && first_letter->second != alpha)
+                continue;
 
-            for (auto neigh : neighbours)
-                regauto.RemoveEdge(state, neigh, alpha);
+            for (auto neighbour : neighbours)
+                result.AddEdge(state, neighbour, alpha);
         }
+    });
+}
 
-        for (auto &[neigh, alpha] : transitions)
-            regauto.AddEdge(state, neigh, alpha);
-    }
-
-    while (regauto.GetNumberOfStates() > 2) // 2 = start and end
-    {
-        auto processing_state = regauto.GetStartState();
-
-        auto states_set = regauto.GetStateNumbers();
-        std::vector states(states_set.begin(), states_set.end());
-        std::random_shuffle(states.begin(), states.end());
-        for (auto state : states)
-        {
-            if (state != processing_state && !regauto.IsStateFinal(state))
-            {
-                processing_state = state;
+Automaton AutomatonTransformer::ExpandAlphabet(const Automaton &automaton, const AlphabetClasses &classes)
+{
+    auto class_letters = GetClassLetters(classes);
 
-                break;
-            }
-        }
-        if (processing_state == regauto.GetStartState())
-            return "Error in start or final state notation.";
+    std::set<Automaton::alpha_t> alphabet = automaton.GetAlphabet();
+    for (auto [letter, first_letter] : classes)
+        alphabet.insert(letter);
 
-        std::map<size_t, std::string> incoming_edges = {};
-        std::string loop = "";
-        for (auto state : regauto.GetStateNumbers())
+    return CopyStates(automaton, std::move(alphabet), [&](size_t state, Automaton &result)
+    {
+        for (auto &[alpha, neighbours] : automaton.GetNeighbours(state))
         {
-            for (auto &alpha_neigh : regauto.GetNeighbours(state))
+            auto letters = class_letters.find(alpha);
+            for (auto neighbour : neighbours)
             {
-                if (alpha_neigh.second.contains(processing_state))
+                if (letters == class_letters.end())
                 {
-                    if (state != processing_state)
-                    {
-                        incoming_edges.insert({state, alpha_neigh.first});
-                    }
-                    else
-                    {
-                        if (loop != "")
-                            return "Two or more loops in one vertex";
-
-                        loop = alpha_neigh.first;
-                    }
+                    result.AddEdge(state, neighbour, alpha);
+                    continue;
                 }
+
+                for (auto letter : letters->second)
+                    result.AddEdge(state, neighbour, letter);
             }
         }
+    });
+}
 
-        for (auto &income : incoming_edges)
-        {
-            for (auto &alpha_neigh : regauto.GetNeighbours(processing_state))
-            {
-                for (auto &neigh : alpha_neigh.second)
-                {
-                    auto outcome = std::make_pair(neigh, alpha_neigh.first);
-
-                    std::string new_string = "";
-                    bool empty_income = income.second == RegularAutomaton::Epsilon;
-                    bool empty_outcome = outcome.second == RegularAutomaton::Epsilon;
-                    bool empty_loop = loop == "" || loop == RegularAutomaton::Epsilon;
-
-                    if (empty_income && empty_outcome && empty_loop)
-                    {
-                        new_string = RegularAutomaton::Epsilon;
-                    }
-                    else 
-                    {
-                        if (!empty_income)
-                        {
-                            bool need_brackets = income.second.length() > 1 &&
-                                               income.second.find('+') != std::string::npos &&
-                                               (empty_outcome && empty_loop);
-
-                            if (need_brackets)
-                                new_string += "(";
-
-                            new_string += income.second;
-
-                            if (need_brackets)
-                                new_string += ")";
-                        }
-                        if (!empty_loop)
-                        {
-                            bool need_repeat = !(loop.length() == 2 && loop[1] == '*'); //TODO: think about smart check
-                            bool need_brackets = need_repeat && loop.length() > 1;
-
-                            if (need_brackets)
-                                new_string += "(";
-
-                            new_string += loop;
-
-                            if (need_brackets)
-                                new_string += ")";
-
-                            if (need_repeat)
-                                new_string += "*";
-                        }
-                        if (!empty_outcome)
-                        {
-                            bool need_brackets = outcome.second.length() > 1 &&
-                                               outcome.second.find('+') != std::string::npos &&
-                                               !(empty_income && empty_loop);
-                            if (need_brackets)
-                                new_string += "(";
-
-                            new_string += outcome.second;
-
-                            if (need_brackets) 
-                                new_string += ")";
-                        }
-                    }
-
-                    std::string existent_string = "";
-                    for (auto &tmp_alpha_neigh : regauto.GetNeighbours(income.first))
-                    {
-                        if (tmp_alpha_neigh.second.contains(outcome.first))
-                        {
-                            if (existent_string != "")
-                                return "Error: two or more edges between two vertices.";
-
-                            existent_string = tmp_alpha_neigh.first;
-                        }
-                    }
+// State elimination over a generalized automaton whose edges are labelled
+// with nodes of a regular expression DAG. A new start state and a new final
+// state are added, and the original states are eliminated in the order of the
+// smallest number of paths through them, (in-degree) x (out-degree), with
+// ties broken by the state number, so the result is deterministic.
+std::string AutomatonTransformer::RegExpr(const Automaton &automaton)
+{
+    static const char *EmptyLanguage = "[Empty language]";
 
-                    if (existent_string == "")
-                    {
-                        regauto.RemoveEdge(income.first, outcome.first, existent_string);
-                        regauto.AddEdge(income.first, outcome.first, new_string);
-                    }
-                    else if (new_string != RegularAutomaton::Epsilon)
-                    {
-                        regauto.RemoveEdge(income.first, outcome.first, existent_string);
-                        regauto.AddEdge(income.first, outcome.first, existent_string + " + " + new_string);
-                    }
-                }
-            }
-        }
+    AUTOMATON_STAGE("RegExpr");
+    AUTOMATON_STAGE_INPUT(automaton);
 
-        regauto.RemoveState(processing_state);
+    if (automaton.GetFinalStates().empty())
+    {
+        std::string expression = EmptyLanguage;
+        AUTOMATON_STAGE_OUTPUT(expression);
+        return expression;
     }
 
-    size_t start = regauto.GetStartState();
-    size_t end = *regauto.GetFinalStates().begin();
-    std::string reg_expr = "";
-    std::string start_loop = "";
-    std::string end_expr = "";
+    FlatAutomaton flat(automaton);
+    uint32_t number_of_states = static_cast<uint32_t>(flat.GetNumberOfStates());
+    uint32_t start = number_of_states;
+    uint32_t end = number_of_states + 1;
 
-    for (auto &alpha_neigh : regauto.GetNeighbours(start))
+    RegularExpressionPool pool;
+    GeneralizedAutomaton generalized(number_of_states + 2);
+
+    generalized.AddEdge(start, flat.GetStartState(), RegularExpressionPool::EmptyWord, pool);
+    for (FlatAutomaton::state_t state = 0; state < number_of_states; ++state)
     {
-        if (alpha_neigh.second.contains(start))
-        {
-            if (start_loop != "")
-                return "Unexpected error";
+        if (flat.IsStateFinal(state))
+            generalized.AddEdge(state, end, RegularExpressionPool::EmptyWord, pool);
 
-            start_loop = alpha_neigh.first;
-        }
-        if (alpha_neigh.second.contains(end))
+        auto symbols = flat.GetSymbols(state);
+        auto targets = flat.GetTargets(state);
+        for (size_t edge = 0; edge < targets.size(); ++edge)
         {
-            if (end_expr != "")
-                return "Unexpected error";
-
-            end_expr = alpha_neigh.first;
+            auto label = symbols[edge] == flat.GetEpsilonSymbol() ? RegularExpressionPool::EmptyWord
+                                                                  : pool.MakeSymbol(flat.GetAlphabet()[symbols[edge]]);
+            generalized.AddEdge(state, targets[edge], label, pool);
         }
     }
 
-    if (end_expr == "")
-        return EmptyLanguage;
+    using candidate_t = std::pair<uint64_t, uint32_t>;
+    std::priority_queue<candidate_t, std::vector<candidate_t>, std::greater<candidate_t>> candidates;
+    for (uint32_t state = 0; state < number_of_states; ++state)
+        candidates.push({generalized.GetEliminationCost(state), state});
 
-    if (start_loop != "" && start_loop != RegularAutomaton::Epsilon)
-    {
-        bool need_repeat = !(start_loop.length() == 2 && start_loop[1] == '*'); //TODO: think about smart check
-        bool need_brackets = need_repeat && start_loop.length() > 1;
+    std::vector<bool> eliminated(number_of_states, false);
+    std::vector<uint32_t> neighbours;
 
-        if (need_brackets)
-            reg_expr += "(";
+    while (!candidates.empty())
+    {
+        auto [cost, state] = candidates.top();
+        candidates.pop();
 
-        reg_expr += start_loop;
+        if (eliminated[state] || cost != generalized.GetEliminationCost(state))
+            continue;
 
-        if (need_brackets)
-            reg_expr += ")";
+        eliminated[state] = true;
+        generalized.Eliminate(state, pool, neighbours);
 
-        if (need_repeat)
-            reg_expr += "*";
+        for (auto neighbour : neighbours)
+        {
+            if (neighbour < number_of_states && !eliminated[neighbour])
+                candidates.push({generalized.GetEliminationCost(neighbour), neighbour});
+        }
     }
 
-    if (end_expr != RegularAutomaton::Epsilon || reg_expr == "")
-    {
-        bool need_brackets = end_expr.length() > 1 && end_expr.find('+') != std::string::npos;
+    auto result = generalized.GetLabel(start, end);
+    std::string expression = result == RegularExpressionPool::EmptySet ? EmptyLanguage : pool.ToString(pool.Simplify(result));
 
-        if (need_brackets)
-            reg_expr += "(" + end_expr + ")";
-        else
-            reg_expr += end_expr;
-    }
-    return reg_expr;
-}
\ No newline at end of file
+    AUTOMATON_STAGE_OUTPUT(expression);
+    return expression;
+}
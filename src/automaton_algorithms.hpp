@@ -1,9 +1,34 @@
 #pragma once
 
+#include <map>
+#include <string_view>
+
 #include "automaton.hpp"
+#include "flat_automaton.hpp"
 
 namespace AutomatonTransformer
 {
+    enum class MinimizationAlgorithm
+    {
+        Moore,
+        Hopcroft,
+        ParallelMoore,
+    };
+
+    enum class NFAReduction
+    {
+        Bisimulation,
+        Simulation,
+    };
+
+    enum class ProductOperation
+    {
+        Intersection,
+        Union,
+        Difference,
+        SymmetricDifference,
+    };
+
     void RemoveEpsTransitions(Automaton &automaton);
     void InverseCDFA(Automaton &automaton);
     void MinimizeCDFA(Automaton &automaton);
@@ -12,7 +37,105 @@ namespace AutomatonTransformer
     Automaton DFAFromNFA(const Automaton &automaton);
     Automaton CDFAFromDFA(const Automaton &automaton);
     Automaton ComplementOfCDFA(const Automaton &automaton);
-    Automaton MCDFAFromCDFA(const Automaton &automaton);
+    Automaton MCDFAFromCDFA(const Automaton &automaton,
+                            MinimizationAlgorithm algorithm = MinimizationAlgorithm::Hopcroft);
+
+    // Automaton of the reversed language: the edges are reversed and a new
+    // start state gets the reversed edges into the final states, so no
+    // epsilon edges are added. The old start state becomes the only final one.
+    Automaton Reverse(const Automaton &automaton);
+
+    // Brzozowski's minimization. Determinizing the reversal of a DFA whose
+    // states are all reachable gives the minimal DFA of the reversed language,
+    // so reversing and determinizing twice gives the minimal complete DFA of
+    // the NFA without minimizing its own subset construction. It pays off when
+    // that construction is much bigger than the minimal DFA, but the DFA of
+    // the reversed language can be exponentially bigger too.
+    Automaton MCDFAFromNFA(const Automaton &automaton);
+
+    // Smaller NFA of the same language to determinize. Useless states are
+    // removed and states with the same future or the same past, by forward
+    // and backward bisimulation, are merged until nothing changes. Simulation
+    // also merges states simulating each other and removes edges into states
+    // simulated by another target of the same letter, but needs memory
+    // quadratic in the number of states. Epsilon edges are removed first.
+    Automaton ReduceNFA(const Automaton &automaton, NFAReduction reduction = NFAReduction::Bisimulation);
 
     std::string RegExpr(const Automaton &automaton);
+
+    // Mark the states reachable from the start state, or the useful ones that
+    // also reach a final state; the start state is always useful. Linear in
+    // the number of transitions. Return the number of marked states.
+    size_t GetReachableStates(const FlatAutomaton &automaton, std::vector<uint8_t> &reachable);
+    size_t GetReachableStates(const DenseDFA &automaton, std::vector<uint8_t> &reachable);
+    size_t GetUsefulStates(const FlatAutomaton &automaton, std::vector<uint8_t> &useful);
+
+    // Removes the states that are not useful and keeps the numbers of the
+    // others, so a complete DFA may become incomplete.
+    void Trim(Automaton &automaton);
+
+    using AlphabetClasses = std::map<Automaton::alpha_t, Automaton::alpha_t>;
+
+    // Letters with the same targets in every state are equivalent. Maps every
+    // letter of the alphabet to the smallest letter of its class.
+    AlphabetClasses GetAlphabetClasses(const Automaton &automaton);
+
+    // The automaton over the smallest letters of the classes, and back.
+    Automaton CompressAlphabet(const Automaton &automaton, const AlphabetClasses &classes);
+    Automaton ExpandAlphabet(const Automaton &automaton, const AlphabetClasses &classes);
+
+    // Epsilon-free Glushkov automaton of an expression in the notation of
+    // RegExpr: '+' is union, '*' is star, '1' is the empty word, letters and
+    // "[n]" are symbols, and "[Empty language]" is the empty language.
+    // Returns the empty language on a syntax error too.
+    Automaton AutomatonFromRegExpr(std::string_view expression,
+                                   std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    void MakeDFAComplete(DenseDFA &automaton);
+
+    DenseDFA DFAFromNFA(const FlatAutomaton &automaton);
+    DenseDFA CDFAFromDFA(const DenseDFA &automaton);
+    DenseDFA MCDFAFromCDFA(const DenseDFA &automaton,
+                           MinimizationAlgorithm algorithm = MinimizationAlgorithm::Hopcroft);
+
+    // Minimal complete DFA of the union of the patterns whose final states
+    // carry the indices of the patterns they accept. The patterns may have
+    // epsilon edges.
+    DenseDFA MultiPatternDFA(const std::vector<Automaton> &patterns,
+                             MinimizationAlgorithm algorithm = MinimizationAlgorithm::Hopcroft);
+
+    // classes[state] < number_of_classes must be compatible with the transitions.
+    DenseDFA QuotientOfDFA(const DenseDFA &automaton, const std::vector<uint32_t> &classes, size_t number_of_classes);
+
+    // The DFA over the states with keep[state] set, in the same order. Their
+    // transitions to the other states are removed.
+    DenseDFA RestrictDFA(const DenseDFA &automaton, const std::vector<uint8_t> &keep);
+
+    // DFA of the operation applied to the languages of two DFAs over the union
+    // of their alphabets. The result holds only reachable pairs that can reach
+    // a final state, so it may be incomplete. Pairs of equivalent operand
+    // states are merged, but the product itself isn't minimized: states with
+    // different pairs may still be equivalent, so MCDFAFromCDFA makes it minimal.
+    Automaton ProductOfDFA(const Automaton &first, const Automaton &second, ProductOperation operation);
+    DenseDFA ProductOfDFA(const DenseDFA &first, const DenseDFA &second, ProductOperation operation);
+
+    // On failure the counterexample gets a shortest word accepted by exactly one
+    // of the automata. DFAs are compared with Hopcroft-Karp, NFAs with the
+    // antichain algorithm without full determinization.
+    bool Equivalent(const Automaton &first, const Automaton &second,
+                    std::vector<Automaton::alpha_t> *counterexample = nullptr);
+    bool Equivalent(const DenseDFA &first, const DenseDFA &second,
+                    std::vector<Automaton::alpha_t> *counterexample = nullptr);
+
+    // Checks that every word accepted by second is accepted by first. On
+    // failure the counterexample gets a shortest word accepted only by second.
+    bool Includes(const Automaton &first, const Automaton &second,
+                  std::vector<Automaton::alpha_t> *counterexample = nullptr);
+
+    // number_of_threads = 0 uses every hardware thread.
+    Automaton ParallelDFAFromNFA(const Automaton &automaton, size_t number_of_threads = 0);
+    DenseDFA ParallelDFAFromNFA(const FlatAutomaton &automaton, size_t number_of_threads = 0);
+
+    Automaton ParallelMCDFAFromCDFA(const Automaton &automaton, size_t number_of_threads = 0);
+    DenseDFA ParallelMCDFAFromCDFA(const DenseDFA &automaton, size_t number_of_threads = 0);
 };
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "automaton_serialization.hpp"
+#include "subset_table.hpp"
+
+namespace
+{
+    const char Magic[8] = {'A', 'U', 'T', 'O', 'M', 'A', 'T', 'N'};
+    const uint32_t Byte_order_mark = 0x01020304;
+
+    const size_t Alignment = 8;
+    const size_t Max_sections = 8;
+    const size_t Max_values = 4;
+
+    enum class ImageKind : uint32_t
+    {
+        Automaton = 1,
+        DenseDFA = 2,
+        CompiledDFA = 3,
+    };
+
+    struct Section
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t kind;
+        uint32_t number_of_sections;
+        uint64_t file_size;
+
+        // Of everything after the header, padding included.
+        uint64_t checksum;
+
+        uint64_t values[Max_values];
+        Section sections[Max_sections];
+    };
+
+    size_t AlignUp(size_t size) { return (size + Alignment - 1) / Alignment * Alignment; }
+
+    uint64_t UpdateChecksum(uint64_t checksum, std::span<const std::byte> bytes)
+    {
+        size_t position = 0;
+        for (; position + sizeof(uint64_t) <= bytes.size(); position += sizeof(uint64_t))
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes.data() + position, sizeof(word));
+            checksum = SubsetTable::HashElement(checksum ^ word);
+        }
+
+        if (position != bytes.size())
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes.data() + position, bytes.size() - position);
+            checksum = SubsetTable::HashElement(checksum ^ word);
+        }
+
+        return checksum;
+    }
+
+    // Collects the arrays of an image and writes them after the header.
+    class ImageWriter
+    {
+        public:
+            explicit ImageWriter(ImageKind kind):
+                header_(),
+                sections_()
+            {
+                std::memcpy(header_.magic, Magic, sizeof(Magic));
+                header_.version = AutomatonSerializer::Format_version;
+                header_.byte_order = Byte_order_mark;
+                header_.kind = static_cast<uint32_t>(kind);
+            }
+
+            void SetValue(size_t index, uint64_t value) { header_.values[index] = value; }
+
+            template <class element_t>
+            void AddSection(std::span<const element_t> elements) { sections_.push_back(std::as_bytes(elements)); }
+
+            bool Write(const std::string &path)
+            {
+                uint64_t offset = AlignUp(sizeof(Header));
+                uint64_t checksum = 0;
+
+                header_.number_of_sections = static_cast<uint32_t>(sections_.size());
+                for (size_t index = 0; index < sections_.size(); ++index)
+                {
+                    header_.sections[index] = {offset, sections_[index].size()};
+                    offset += AlignUp(sections_[index].size());
+                    checksum = UpdateChecksum(checksum, sections_[index]);
+                }
+
+                header_.file_size = offset;
+                header_.checksum = checksum;
+
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                if (!file)
+                {
+                    std::cerr << "Can't open file for the automaton: \"" << path << "\"\n";
+                    return false;
+                }
+
+                const char padding[Alignment] = {};
+                file.write(reinterpret_cast<const char *>(&header_), sizeof(Header));
+                file.write(padding, static_cast<std::streamsize>(AlignUp(sizeof(Header)) - sizeof(Header)));
+
+                for (auto section : sections_)
+                {
+                    file.write(reinterpret_cast<const char *>(section.data()), static_cast<std::streamsize>(section.size()));
+                    file.write(padding, static_cast<std::streamsize>(AlignUp(section.size()) - section.size()));
+                }
+
+                if (!file.flush())
+                {
+                    std::cerr << "Can't write the automaton to the file: \"" << path << "\"\n";
+                    return false;
+                }
+
+                return true;
+            }
+
+        private:
+            Header header_;
+            std::vector<std::span<const std::byte>> sections_;
+    };
+
+    // Read-only mapping of a whole file, unmapped with the last reference.
+    std::shared_ptr<const std::byte> MapFile(const std::string &path, size_t &size)
+    {
+        int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+        {
+            std::cerr << "Can't open file with the automaton: \"" << path << "\"\n";
+            return nullptr;
+        }
+
+        struct stat file_status = {};
+        if (fstat(descriptor, &file_status) != 0 || file_status.st_size <= 0)
+        {
+            std::cerr << "Can't read file with the automaton: \"" << path << "\"\n";
+            close(descriptor);
+            return nullptr;
+        }
+
+        size = static_cast<size_t>(file_status.st_size);
+        void *address = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+        close(descriptor);
+
+        if (address == MAP_FAILED)
+        {
+            std::cerr << "Can't map file with the automaton: \"" << path << "\"\n";
+            return nullptr;
+        }
+
+        return std::shared_ptr<const std::byte>(static_cast<const std::byte *>(address),
+                                                [size](const std::byte *mapped) { munmap(const_cast<std::byte *>(mapped), size); });
+    }
+
+    // Checks the header of a mapped image and gives the arrays in place.
+    class ImageReader
+    {
+        public:
+            ImageReader(const std::string &path, ImageKind kind, bool verify):
+                path_(path),
+                size_(0),
+                file_(MapFile(path, size_)),
+                header_(nullptr)
+            {
+                if (!file_)
+                    return;
+
+                if (size_ < sizeof(Header))
+                {
+                    Fail("File is too short");
+                    return;
+                }
+
+                header_ = reinterpret_cast<const Header *>(file_.get());
+                if (std::memcmp(header_->magic, Magic, sizeof(Magic)) != 0)
+                    Fail("File doesn't contain an automaton");
+                else if (header_->version != AutomatonSerializer::Format_version)
+                    Fail("Unsupported format version");
+                else if (header_->byte_order != Byte_order_mark)
+                    Fail("File was written with another byte order");
+                else if (header_->kind != static_cast<uint32_t>(kind))
+                    Fail("File contains another kind of automaton");
+                else if (header_->file_size != size_ || header_->number_of_sections > Max_sections)
+                    Fail("File is truncated or damaged");
+                else if (!CheckSections())
+                    Fail("File is damaged");
+                else if (verify && !CheckChecksum())
+                    Fail("Checksum mismatch");
+            }
+
+            bool IsValid() const { return header_ != nullptr; }
+
+            uint64_t GetValue(size_t index) const { return header_->values[index]; }
+
+            template <class element_t>
+            std::span<const element_t> GetSection(size_t index) const
+            {
+                if (index >= header_->number_of_sections)
+                    return {};
+
+                auto &section = header_->sections[index];
+                return {reinterpret_cast<const element_t *>(file_.get() + section.offset), section.size / sizeof(element_t)};
+            }
+
+            // Keeps the mapping alive.
+            std::shared_ptr<const void> GetStorage() const { return file_; }
+
+            bool Fail(const char *error)
+            {
+                std::cerr << error << ": \"" << path_ << "\"\n";
+
+                header_ = nullptr;
+                return false;
+            }
+
+        private:
+            std::string path_;
+            size_t size_;
+            std::shared_ptr<const std::byte> file_;
+            const Header *header_;
+
+            bool CheckSections() const
+            {
+                for (size_t index = 0; index < header_->number_of_sections; ++index)
+                {
+                    auto &section = header_->sections[index];
+                    if (section.offset % Alignment != 0 || section.offset > size_ || section.size > size_ - section.offset)
+                        return false;
+                }
+
+                return true;
+            }
+
+            bool CheckChecksum() const
+            {
+                auto payload = std::span<const std::byte>(file_.get(), size_).subspan(AlignUp(sizeof(Header)));
+                return UpdateChecksum(0, payload) == header_->checksum;
+            }
+    };
+
+    enum AutomatonSection
+    {
+        Automaton_alphabet,
+        Automaton_states,
+        Automaton_final_states,
+        Automaton_edges,
+    };
+
+    enum DenseDFASection
+    {
+        Dense_alphabet,
+        Dense_table,
+        Dense_final,
+        Dense_accept_offsets,
+        Dense_accept_ids,
+    };
+
+    enum CompiledDFASection
+    {
+        Compiled_byte_classes,
+        Compiled_table,
+        Compiled_accepting,
+        Compiled_acceleration,
+        Compiled_accept_offsets,
+        Compiled_accept_ids,
+    };
+
+    // Offsets must grow from 0 to the number of IDs.
+    bool AreOffsetsValid(std::span<const uint32_t> offsets, size_t number_of_states, size_t number_of_ids)
+    {
+        if (offsets.empty())
+            return number_of_ids == 0;
+
+        if (offsets.size() != number_of_states + 1 || offsets.front() != 0 || offsets.back() != number_of_ids)
+            return false;
+
+        return std::is_sorted(offsets.begin(), offsets.end());
+    }
+};
+
+bool AutomatonSerializer::Save(const Automaton &automaton, const std::string &path)
+{
+    std::vector<int32_t> alphabet(automaton.GetAlphabet().begin(), automaton.GetAlphabet().end());
+    std::vector<uint64_t> states(automaton.GetStateNumbers().begin(), automaton.GetStateNumbers().end());
+    std::vector<uint64_t> final_states(automaton.GetFinalStates().begin(), automaton.GetFinalStates().end());
+
+    // Triples of source, target and letter.
+    std::vector<uint64_t> edges;
+    for (auto state : automaton.GetStateNumbers())
+    {
+        for (auto &[letter, neighbours] : automaton.GetNeighbours(state))
+        {
+            for (auto neighbour : neighbours)
+                edges.insert(edges.end(), {state, neighbour, static_cast<uint64_t>(static_cast<int64_t>(letter))});
+        }
+    }
+
+    ImageWriter writer(ImageKind::Automaton);
+    writer.SetValue(0, automaton.GetStartState());
+    writer.AddSection(std::span<const int32_t>(alphabet));
+    writer.AddSection(std::span<const uint64_t>(states));
+    writer.AddSection(std::span<const uint64_t>(final_states));
+    writer.AddSection(std::span<const uint64_t>(edges));
+
+    return writer.Write(path);
+}
+
+bool AutomatonSerializer::Save(const DenseDFA &automaton, const std::string &path)
+{
+    size_t number_of_states = automaton.GetNumberOfStates();
+
+    std::vector<int32_t> alphabet(automaton.GetAlphabet().begin(), automaton.GetAlphabet().end());
+    std::vector<uint32_t> table;
+    std::vector<uint8_t> final(number_of_states, false);
+
+    table.reserve(number_of_states * alphabet.size());
+    for (DenseDFA::state_t state = 0; state < number_of_states; ++state)
+    {
+        auto row = automaton.GetRow(state);
+        table.insert(table.end(), row.begin(), row.end());
+        final[state] = automaton.IsStateFinal(state);
+    }
+
+    std::vector<uint32_t> accept_offsets;
+    std::vector<uint64_t> accept_ids;
+    if (automaton.HasAcceptIds())
+    {
+        accept_offsets.push_back(0);
+        for (DenseDFA::state_t state = 0; state < number_of_states; ++state)
+        {
+            auto ids = automaton.GetAcceptIds(state);
+            accept_ids.insert(accept_ids.end(), ids.begin(), ids.end());
+            accept_offsets.push_back(static_cast<uint32_t>(accept_ids.size()));
+        }
+    }
+
+    ImageWriter writer(ImageKind::DenseDFA);
+    writer.SetValue(0, number_of_states);
+    writer.SetValue(1, automaton.GetStartState());
+    writer.AddSection(std::span<const int32_t>(alphabet));
+    writer.AddSection(std::span<const uint32_t>(table));
+    writer.AddSection(std::span<const uint8_t>(final));
+    writer.AddSection(std::span<const uint32_t>(accept_offsets));
+    writer.AddSection(std::span<const uint64_t>(accept_ids));
+
+    return writer.Write(path);
+}
+
+bool AutomatonSerializer::Save(const CompiledDFA &automaton, const std::string &path)
+{
+    ImageWriter writer(ImageKind::CompiledDFA);
+    writer.SetValue(0, automaton.start_state_);
+    writer.SetValue(1, automaton.row_shift_);
+    writer.AddSection(automaton.byte_classes_);
+    writer.AddSection(automaton.table_);
+    writer.AddSection(automaton.accepting_);
+    writer.AddSection(automaton.acceleration_);
+    writer.AddSection(automaton.accept_offsets_);
+    writer.AddSection(automaton.accept_ids_);
+
+    return writer.Write(path);
+}
+
+bool AutomatonSerializer::Load(const std::string &path, Automaton &automaton)
+{
+    ImageReader reader(path, ImageKind::Automaton, true);
+    if (!reader.IsValid())
+        return false;
+
+    auto alphabet = reader.GetSection<int32_t>(Automaton_alphabet);
+    auto states = reader.GetSection<uint64_t>(Automaton_states);
+    auto final_states = reader.GetSection<uint64_t>(Automaton_final_states);
+    auto edges = reader.GetSection<uint64_t>(Automaton_edges);
+
+    std::set<Automaton::alpha_t> letters;
+    for (auto letter : alphabet)
+        letters.insert(static_cast<Automaton::alpha_t>(letter));
+
+    Automaton result(std::move(letters), 1, automaton.GetMemoryResource());
+    result.SetStates(0);
+    for (auto state : states)
+        result.AddState(state);
+
+    auto exists = [&](uint64_t state) { return result.DoesStateExist(state); };
+    if (states.empty() || !exists(reader.GetValue(0)) || edges.size() % 3 != 0 ||
+        !std::all_of(final_states.begin(), final_states.end(), exists))
+        return reader.Fail("File is damaged");
+
+    result.SetStartState(reader.GetValue(0));
+    for (auto state : final_states)
+        result.SetFinal(state);
+
+    for (size_t edge = 0; edge < edges.size(); edge += 3)
+    {
+        if (!exists(edges[edge]) || !exists(edges[edge + 1]))
+            return reader.Fail("File is damaged");
+
+        result.AddEdge(edges[edge], edges[edge + 1], static_cast<Automaton::alpha_t>(static_cast<int64_t>(edges[edge + 2])));
+    }
+
+    automaton = std::move(result);
+    return true;
+}
+
+bool AutomatonSerializer::Load(const std::string &path, DenseDFA &automaton)
+{
+    ImageReader reader(path, ImageKind::DenseDFA, true);
+    if (!reader.IsValid())
+        return false;
+
+    auto alphabet = reader.GetSection<int32_t>(Dense_alphabet);
+    auto table = reader.GetSection<uint32_t>(Dense_table);
+    auto final = reader.GetSection<uint8_t>(Dense_final);
+    auto accept_offsets = reader.GetSection<uint32_t>(Dense_accept_offsets);
+    auto accept_ids = reader.GetSection<uint64_t>(Dense_accept_ids);
+
+    uint64_t number_of_states = reader.GetValue(0);
+    if (number_of_states == 0 || number_of_states > std::numeric_limits<DenseDFA::state_t>::max() ||
+        reader.GetValue(1) >= number_of_states || final.size() != number_of_states ||
+        table.size() != number_of_states * alphabet.size() ||
+        !AreOffsetsValid(accept_offsets, number_of_states, accept_ids.size()))
+        return reader.Fail("File is damaged");
+
+    auto is_valid_target = [&](uint32_t target) { return target == DenseDFA::NoState || target < number_of_states; };
+    if (!std::all_of(table.begin(), table.end(), is_valid_target))
+        return reader.Fail("File is damaged");
+
+    DenseDFA result(std::vector<Automaton::alpha_t>(alphabet.begin(), alphabet.end()), number_of_states);
+    result.SetStartState(static_cast<DenseDFA::state_t>(reader.GetValue(1)));
+
+    std::vector<size_t> ids;
+    for (DenseDFA::state_t state = 0; state < number_of_states; ++state)
+    {
+        result.SetFinal(state, final[state]);
+        for (size_t symbol = 0; symbol < alphabet.size(); ++symbol)
+            result.SetTransition(state, symbol, table[state * alphabet.size() + symbol]);
+
+        if (accept_offsets.empty())
+            continue;
+
+        ids.assign(accept_ids.begin() + accept_offsets[state], accept_ids.begin() + accept_offsets[state + 1]);
+        result.SetAcceptIds(state, ids);
+    }
+
+    automaton = std::move(result);
+    return true;
+}
+
+bool AutomatonSerializer::Load(const std::string &path, CompiledDFA &automaton, bool verify)
+{
+    ImageReader reader(path, ImageKind::CompiledDFA, verify);
+    if (!reader.IsValid())
+        return false;
+
+    auto byte_classes = reader.GetSection<uint8_t>(Compiled_byte_classes);
+    auto table = reader.GetSection<CompiledDFA::state_t>(Compiled_table);
+    auto accepting = reader.GetSection<uint8_t>(Compiled_accepting);
+    auto acceleration = reader.GetSection<CompiledDFA::Accelerator>(Compiled_acceleration);
+    auto accept_offsets = reader.GetSection<uint32_t>(Compiled_accept_offsets);
+    auto accept_ids = reader.GetSection<uint32_t>(Compiled_accept_ids);
+
+    uint64_t start_state = reader.GetValue(0);
+    uint64_t row_shift = reader.GetValue(1);
+    if (row_shift >= 64 || (uint64_t(1) << row_shift) > CompiledDFA::Number_of_bytes || byte_classes.size() != CompiledDFA::Number_of_bytes)
+        return reader.Fail("File is damaged");
+
+    uint64_t row_size = uint64_t(1) << row_shift;
+    auto is_valid_class = [&](uint8_t byte_class) { return byte_class < row_size; };
+
+    if (!std::all_of(byte_classes.begin(), byte_classes.end(), is_valid_class) ||
+        accepting.empty() || table.size() != (accepting.size() << row_shift) || acceleration.size() != accepting.size() ||
+        start_state >= table.size() || start_state % row_size != 0 ||
+        !AreOffsetsValid(accept_offsets, accepting.size(), accept_ids.size()))
+        return reader.Fail("File is damaged");
+
+    auto is_valid_accelerator = [](const CompiledDFA::Accelerator &accelerator)
+    {
+        return accelerator.size <= CompiledDFA::Max_accelerated_bytes ||
+               accelerator.size == CompiledDFA::Accelerator::Byte_class ||
+               accelerator.size == CompiledDFA::Accelerator::Not_accelerated;
+    };
+
+    if (!std::all_of(acceleration.begin(), acceleration.end(), is_valid_accelerator))
+        return reader.Fail("File is damaged");
+
+    auto is_valid_target = [&](CompiledDFA::state_t target)
+    {
+        return target < table.size() && target % row_size == 0;
+    };
+
+    if (verify && !std::all_of(table.begin(), table.end(), is_valid_target))
+        return reader.Fail("File is damaged");
+
+    automaton.storage_ = reader.GetStorage();
+    automaton.byte_classes_ = byte_classes;
+    automaton.row_shift_ = static_cast<size_t>(row_shift);
+    automaton.table_ = table;
+    automaton.accepting_ = accepting;
+    automaton.acceleration_ = acceleration;
+    automaton.start_state_ = static_cast<CompiledDFA::state_t>(start_state);
+    automaton.accept_offsets_ = accept_offsets;
+    automaton.accept_ids_ = accept_ids;
+
+    return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+#include "automaton.hpp"
+#include "compiled_dfa.hpp"
+#include "flat_automaton.hpp"
+
+// Binary images of automata: a header with a magic word, a format version,
+// the byte order and a checksum, followed by arrays aligned to 8 bytes. The
+// image of a CompiledDFA is its transition table as it is used by the
+// scanner, so loading maps the file and uses it in place, and processes
+// loading the same file share its pages. Functions return false and print
+// the reason if the file can't be written or read.
+namespace AutomatonSerializer
+{
+    const uint32_t Format_version = 3;
+
+    bool Save(const Automaton &automaton, const std::string &path);
+    bool Save(const DenseDFA &automaton, const std::string &path);
+    bool Save(const CompiledDFA &automaton, const std::string &path);
+
+    // The automaton is left unchanged if the file is invalid.
+    bool Load(const std::string &path, Automaton &automaton);
+    bool Load(const std::string &path, DenseDFA &automaton);
+
+    // Without verify the checksum and the targets of the transitions are not
+    // checked, so loading doesn't read the table; only files written by Save
+    // and not modified since can be trusted this way.
+    bool Load(const std::string &path, CompiledDFA &automaton, bool verify = true);
+};
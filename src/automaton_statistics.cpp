@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "automaton_statistics.hpp"
+
+namespace
+{
+    const size_t Number_of_counters = static_cast<size_t>(AutomatonStatistics::Counter::NumberOfCounters);
+
+    // Running totals of the counters of the thread; a stage reports the
+    // difference between its end and its start. Plain values, so operator new
+    // can use them at any time of the life of the thread.
+    thread_local size_t thread_counters[Number_of_counters] = {};
+    thread_local AutomatonStatistics::Stage *current_stage = nullptr;
+
+    AutomatonStatistics::callback_t& GetCallback()
+    {
+        static AutomatonStatistics::callback_t callback;
+        return callback;
+    }
+
+    // In the order of AutomatonStatistics::Counter.
+    size_t StageStatistics::*const Counter_fields[Number_of_counters] =
+    {
+        &StageStatistics::subsets,
+        &StageStatistics::hash_probes,
+        &StageStatistics::refinement_rounds,
+        &StageStatistics::allocations,
+        &StageStatistics::allocated_bytes,
+    };
+};
+
+#if defined(AUTOMATON_STATISTICS)
+namespace
+{
+    void CountAllocation(size_t size)
+    {
+        ++thread_counters[static_cast<size_t>(AutomatonStatistics::Counter::Allocations)];
+        thread_counters[static_cast<size_t>(AutomatonStatistics::Counter::AllocatedBytes)] += size;
+    }
+};
+
+// The default operator delete frees memory of both with std::free. The aligned
+// one is used by std::pmr::new_delete_resource, so it covers the automata.
+void* operator new(size_t size)
+{
+    CountAllocation(size);
+
+    void *memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+
+    return memory;
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    CountAllocation(size);
+
+    auto align = static_cast<size_t>(alignment);
+    void *memory = std::aligned_alloc(align, (size + align - 1) / align * align + (size == 0 ? align : 0));
+    if (memory == nullptr)
+        throw std::bad_alloc();
+
+    return memory;
+}
+#endif
+
+void AutomatonStatistics::SetCallback(callback_t callback) { GetCallback() = std::move(callback); }
+
+void AutomatonStatistics::Count(Counter counter, size_t value) { thread_counters[static_cast<size_t>(counter)] += value; }
+
+AutomatonStatistics::counters_t AutomatonStatistics::GetThreadCounters()
+{
+    counters_t counters = {};
+    std::copy(thread_counters, thread_counters + Number_of_counters, counters.begin());
+    return counters;
+}
+
+void AutomatonStatistics::AddCounters(const counters_t &counters)
+{
+    for (size_t counter = 0; counter < Number_of_counters; ++counter)
+        thread_counters[counter] += counters[counter];
+}
+
+void AutomatonStatistics::AddClasses(size_t number_of_classes)
+{
+    if (current_stage != nullptr)
+        current_stage->statistics_.classes_per_round.push_back(number_of_classes);
+}
+
+size_t AutomatonStatistics::CountTransitions(const Automaton &automaton)
+{
+    size_t number_of_transitions = 0;
+    for (auto state : automaton.GetStateNumbers())
+    {
+        for (auto &[alpha, neighbours] : automaton.GetNeighbours(state))
+            number_of_transitions += neighbours.size();
+    }
+
+    return number_of_transitions;
+}
+
+size_t AutomatonStatistics::CountTransitions(const FlatAutomaton &automaton) { return automaton.GetNumberOfTransitions(); }
+
+size_t AutomatonStatistics::CountTransitions(const DenseDFA &automaton)
+{
+    size_t number_of_transitions = 0;
+    for (DenseDFA::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+    {
+        auto row = automaton.GetRow(state);
+        number_of_transitions += static_cast<size_t>(std::count_if(row.begin(), row.end(), [](DenseDFA::state_t target)
+        {
+            return target != DenseDFA::NoState;
+        }));
+    }
+
+    return number_of_transitions;
+}
+
+AutomatonStatistics::Stage::Stage(const char *name):
+    statistics_(),
+    counters_at_start_(),
+    start_(),
+    caller_(current_stage)
+{
+    statistics_.stage = name;
+    std::copy(thread_counters, thread_counters + Number_of_counters, counters_at_start_);
+
+    current_stage = this;
+    start_ = std::chrono::steady_clock::now();
+}
+
+AutomatonStatistics::Stage::~Stage()
+{
+    statistics_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    for (size_t counter = 0; counter < Number_of_counters; ++counter)
+        statistics_.*Counter_fields[counter] = thread_counters[counter] - counters_at_start_[counter];
+
+    current_stage = caller_;
+    if (caller_ != nullptr)
+    {
+        auto &caller_classes = caller_->statistics_.classes_per_round;
+        caller_classes.insert(caller_classes.end(), statistics_.classes_per_round.begin(), statistics_.classes_per_round.end());
+    }
+
+    if (GetCallback())
+        GetCallback()(statistics_);
+}
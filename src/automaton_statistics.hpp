@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "automaton.hpp"
+#include "flat_automaton.hpp"
+
+// Statistics of the stages of the transformation pipeline. They are collected
+// only if the library is compiled with AUTOMATON_STATISTICS defined; without
+// it the macros below expand to nothing, so the algorithms don't pay for them
+// and the callback is never called.
+struct StageStatistics
+{
+    const char *stage = "";
+    double seconds = 0;
+
+    size_t input_states = 0;
+    size_t input_transitions = 0;
+    size_t output_states = 0;
+    size_t output_transitions = 0;
+
+    // Length of the expression built by RegExpr.
+    size_t output_length = 0;
+
+    // Subset construction: subsets created and hash table slots probed.
+    size_t subsets = 0;
+    size_t hash_probes = 0;
+
+    // Moore rounds with the number of classes after every round, or Hopcroft
+    // splitters with the final number of classes.
+    size_t refinement_rounds = 0;
+    std::vector<size_t> classes_per_round;
+
+    // Calls of operator new by the thread running the stage.
+    size_t allocations = 0;
+    size_t allocated_bytes = 0;
+};
+
+namespace AutomatonStatistics
+{
+    using callback_t = std::function<void(const StageStatistics &statistics)>;
+
+    enum class Counter
+    {
+        Subsets,
+        HashProbes,
+        RefinementRounds,
+        Allocations,
+        AllocatedBytes,
+        NumberOfCounters,
+    };
+
+    using counters_t = std::array<size_t, static_cast<size_t>(Counter::NumberOfCounters)>;
+
+    constexpr bool IsEnabled()
+    {
+#if defined(AUTOMATON_STATISTICS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Called on the thread running a stage when it ends. Stages called by
+    // other stages end first, and their counters are included in the
+    // counters of the callers. Not synchronized with running stages.
+    void SetCallback(callback_t callback);
+
+    void Count(Counter counter, size_t value);
+
+    // Running totals of the counters of the calling thread. Threads helping a
+    // stage hand the difference of their totals to the thread running it,
+    // which adds them to its own with AddCounters.
+    counters_t GetThreadCounters();
+    void AddCounters(const counters_t &counters);
+    void AddClasses(size_t number_of_classes);
+
+    size_t CountTransitions(const Automaton &automaton);
+    size_t CountTransitions(const FlatAutomaton &automaton);
+    size_t CountTransitions(const DenseDFA &automaton);
+
+    class Stage
+    {
+        public:
+            explicit Stage(const char *name);
+            ~Stage();
+
+            Stage(const Stage &other) = delete;
+            Stage& operator=(const Stage &other) = delete;
+
+            template <class automaton_t>
+            void SetInput(const automaton_t &automaton)
+            {
+                statistics_.input_states = automaton.GetNumberOfStates();
+                statistics_.input_transitions = CountTransitions(automaton);
+            }
+
+            template <class automaton_t>
+            void SetOutput(const automaton_t &automaton)
+            {
+                statistics_.output_states = automaton.GetNumberOfStates();
+                statistics_.output_transitions = CountTransitions(automaton);
+            }
+
+            void SetOutput(const std::string &expression)
+            {
+                statistics_.output_length = expression.size();
+            }
+
+        private:
+            StageStatistics statistics_;
+            size_t counters_at_start_[static_cast<size_t>(Counter::NumberOfCounters)];
+            std::chrono::steady_clock::time_point start_;
+            Stage *caller_;
+
+            friend void AddClasses(size_t number_of_classes);
+    };
+};
+
+#if defined(AUTOMATON_STATISTICS)
+#define AUTOMATON_STAGE(name) AutomatonStatistics::Stage automaton_stage(name)
+#define AUTOMATON_STAGE_INPUT(automaton) automaton_stage.SetInput(automaton)
+#define AUTOMATON_STAGE_OUTPUT(automaton) automaton_stage.SetOutput(automaton)
+#define AUTOMATON_COUNT(counter, value) AutomatonStatistics::Count(AutomatonStatistics::Counter::counter, value)
+#define AUTOMATON_CLASSES(number_of_classes) AutomatonStatistics::AddClasses(number_of_classes)
+#else
+#define AUTOMATON_STAGE(name) do {} while (false)
+#define AUTOMATON_STAGE_INPUT(automaton) do {} while (false)
+#define AUTOMATON_STAGE_OUTPUT(automaton) do {} while (false)
+#define AUTOMATON_COUNT(counter, value) do {} while (false)
+#define AUTOMATON_CLASSES(number_of_classes) do {} while (false)
+#endif
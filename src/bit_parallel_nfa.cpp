@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+
+#include "bit_parallel_nfa.hpp"
+
+BitParallelNFA::BitParallelNFA(const Automaton &automaton):
+    number_of_states_(0),
+    number_of_words_(0),
+    alphabet_size_(0),
+    number_of_chunks_(0),
+    symbols_(),
+    start_(),
+    final_(),
+    successors_(),
+    chunk_tables_()
+{
+    FlatAutomaton flat(automaton);
+
+    number_of_states_ = flat.GetNumberOfStates();
+    number_of_words_ = (number_of_states_ + Word_size - 1) / Word_size;
+    alphabet_size_ = flat.GetAlphabetSize();
+    number_of_chunks_ = (number_of_states_ + Chunk_size - 1) / Chunk_size;
+
+    for (size_t byte = 0; byte < symbols_.size(); ++byte)
+        symbols_[byte] = flat.GetSymbol(static_cast<Automaton::alpha_t>(byte));
+
+    std::vector<word_t> closures(number_of_states_ * number_of_words_, 0);
+    std::vector<FlatAutomaton::state_t> stack;
+
+    for (FlatAutomaton::state_t state = 0; state < number_of_states_; ++state)
+    {
+        word_t *closure = closures.data() + state * number_of_words_;
+        closure[state / Word_size] |= word_t(1) << (state % Word_size);
+
+        stack.assign(1, state);
+        while (!stack.empty())
+        {
+            auto current = stack.back();
+            stack.pop_back();
+
+            for (auto neighbour : flat.GetTargets(current, flat.GetEpsilonSymbol()))
+            {
+                word_t bit = word_t(1) << (neighbour % Word_size);
+                if (closure[neighbour / Word_size] & bit)
+                    continue;
+
+                closure[neighbour / Word_size] |= bit;
+                stack.push_back(neighbour);
+            }
+        }
+    }
+
+    auto start_closure = closures.begin() + static_cast<std::ptrdiff_t>(flat.GetStartState() * number_of_words_);
+    start_.assign(start_closure, start_closure + static_cast<std::ptrdiff_t>(number_of_words_));
+
+    final_.assign(number_of_words_, 0);
+    for (FlatAutomaton::state_t state = 0; state < number_of_states_; ++state)
+    {
+        if (flat.IsStateFinal(state))
+            final_[state / Word_size] |= word_t(1) << (state % Word_size);
+    }
+
+    successors_.assign(number_of_states_ * alphabet_size_ * number_of_words_, 0);
+    for (FlatAutomaton::state_t state = 0; state < number_of_states_; ++state)
+    {
+        for (size_t symbol = 0; symbol < alphabet_size_; ++symbol)
+        {
+            word_t *successors = successors_.data() + (state * alphabet_size_ + symbol) * number_of_words_;
+            for (auto neighbour : flat.GetTargets(state, static_cast<FlatAutomaton::symbol_t>(symbol)))
+            {
+                const word_t *closure = closures.data() + neighbour * number_of_words_;
+                for (size_t word = 0; word < number_of_words_; ++word)
+                    successors[word] |= closure[word];
+            }
+        }
+    }
+
+    size_t chunk_tables_size = alphabet_size_ * number_of_chunks_ * Chunk_values * number_of_words_;
+    if (chunk_tables_size * sizeof(word_t) > Max_chunk_table_size)
+        return;
+
+    // The row of a chunk value is the row of the value without its lowest bit
+    // plus the successors of the state of that bit.
+    chunk_tables_.assign(chunk_tables_size, 0);
+    for (size_t symbol = 0; symbol < alphabet_size_; ++symbol)
+    {
+        for (size_t chunk = 0; chunk < number_of_chunks_; ++chunk)
+        {
+            for (size_t value = 1; value < Chunk_values; ++value)
+            {
+                size_t state = chunk * Chunk_size + static_cast<size_t>(std::countr_zero(value));
+                word_t *row = chunk_tables_.data() + ((symbol * number_of_chunks_ + chunk) * Chunk_values + value) * number_of_words_;
+                const word_t *previous_row = GetChunkTable(symbol, chunk, value & (value - 1));
+
+                for (size_t word = 0; word < number_of_words_; ++word)
+                    row[word] = previous_row[word];
+
+                if (state >= number_of_states_)
+                    continue;
+
+                const word_t *successors = GetSuccessors(state, symbol);
+                for (size_t word = 0; word < number_of_words_; ++word)
+                    row[word] |= successors[word];
+            }
+        }
+    }
+}
+
+bool BitParallelNFA::Accepts(std::string_view input) const
+{
+    if (number_of_words_ == 1)
+        return AcceptsSingleWord(input);
+
+    std::vector<word_t> active(number_of_words_);
+    std::vector<word_t> next(number_of_words_);
+
+    Start(active);
+    for (auto letter : input)
+    {
+        if (!Step(active, static_cast<unsigned char>(letter), next))
+            return false;
+
+        active.swap(next);
+    }
+
+    return IsAccepting(active);
+}
+
+size_t BitParallelNFA::GetNumberOfStates() const { return number_of_states_; }
+
+size_t BitParallelNFA::GetNumberOfWords() const { return number_of_words_; }
+
+void BitParallelNFA::Start(std::span<word_t> active) const { std::copy(start_.begin(), start_.end(), active.begin()); }
+
+bool BitParallelNFA::Step(std::span<const word_t> active, unsigned char byte, std::span<word_t> next) const
+{
+    std::fill(next.begin(), next.begin() + static_cast<std::ptrdiff_t>(number_of_words_), 0);
+
+    auto symbol = symbols_[byte];
+    if (symbol == FlatAutomaton::NoSymbol)
+        return false;
+
+    if (!chunk_tables_.empty())
+    {
+        for (size_t chunk = 0; chunk < number_of_chunks_; ++chunk)
+        {
+            size_t bit = chunk * Chunk_size;
+            size_t value = (active[bit / Word_size] >> (bit % Word_size)) & (Chunk_values - 1);
+            if (value == 0)
+                continue;
+
+            const word_t *row = GetChunkTable(symbol, chunk, value);
+            for (size_t word = 0; word < number_of_words_; ++word)
+                next[word] |= row[word];
+        }
+    }
+    else
+    {
+        for (size_t word = 0; word < number_of_words_; ++word)
+        {
+            for (word_t bits = active[word]; bits != 0; bits &= bits - 1)
+            {
+                size_t state = word * Word_size + static_cast<size_t>(std::countr_zero(bits));
+                const word_t *successors = GetSuccessors(state, symbol);
+                for (size_t next_word = 0; next_word < number_of_words_; ++next_word)
+                    next[next_word] |= successors[next_word];
+            }
+        }
+    }
+
+    return std::any_of(next.begin(), next.begin() + static_cast<std::ptrdiff_t>(number_of_words_),
+                       [](word_t word) { return word != 0; });
+}
+
+bool BitParallelNFA::IsAccepting(std::span<const word_t> active) const
+{
+    for (size_t word = 0; word < number_of_words_; ++word)
+    {
+        if (active[word] & final_[word])
+            return true;
+    }
+
+    return false;
+}
+
+const BitParallelNFA::word_t* BitParallelNFA::GetSuccessors(size_t state, size_t symbol) const
+{
+    return successors_.data() + (state * alphabet_size_ + symbol) * number_of_words_;
+}
+
+const BitParallelNFA::word_t* BitParallelNFA::GetChunkTable(size_t symbol, size_t chunk, size_t value) const
+{
+    return chunk_tables_.data() + ((symbol * number_of_chunks_ + chunk) * Chunk_values + value) * number_of_words_;
+}
+
+bool BitParallelNFA::AcceptsSingleWord(std::string_view input) const
+{
+    word_t active = start_[0];
+
+    for (auto letter : input)
+    {
+        auto symbol = symbols_[static_cast<unsigned char>(letter)];
+        if (symbol == FlatAutomaton::NoSymbol)
+            return false;
+
+        word_t next = 0;
+        if (!chunk_tables_.empty())
+        {
+            for (size_t chunk = 0; chunk < number_of_chunks_; ++chunk)
+                next |= *GetChunkTable(symbol, chunk, (active >> (chunk * Chunk_size)) & (Chunk_values - 1));
+        }
+        else
+        {
+            for (word_t bits = active; bits != 0; bits &= bits - 1)
+                next |= *GetSuccessors(static_cast<size_t>(std::countr_zero(bits)), symbol);
+        }
+
+        if (next == 0)
+            return false;
+
+        active = next;
+    }
+
+    return (active & final_[0]) != 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "automaton.hpp"
+#include "flat_automaton.hpp"
+
+// Simulates an NFA without determinization: the set of active states is a
+// bitset of GetNumberOfWords() machine words. Successor masks already include
+// epsilon closures. For small automata the successors of every byte-sized
+// chunk of the active set are tabulated, so a step costs one lookup per chunk
+// no matter how many states are active.
+class BitParallelNFA
+{
+    public:
+        using word_t = uint64_t;
+
+        static const size_t Word_size = 64;
+        static const size_t Max_chunk_table_size = 4 << 20;
+
+        explicit BitParallelNFA(const Automaton &automaton);
+
+        bool Accepts(std::string_view input) const;
+
+        size_t GetNumberOfStates() const;
+        size_t GetNumberOfWords() const;
+
+        void Start(std::span<word_t> active) const;
+        bool Step(std::span<const word_t> active, unsigned char byte, std::span<word_t> next) const;
+        bool IsAccepting(std::span<const word_t> active) const;
+
+    private:
+        static const size_t Chunk_size = 8;
+        static const size_t Chunk_values = 1 << Chunk_size;
+
+        size_t number_of_states_;
+        size_t number_of_words_;
+        size_t alphabet_size_;
+        size_t number_of_chunks_;
+
+        std::array<FlatAutomaton::symbol_t, 256> symbols_;
+
+        std::vector<word_t> start_;
+        std::vector<word_t> final_;
+        std::vector<word_t> successors_;
+        std::vector<word_t> chunk_tables_;
+
+        const word_t* GetSuccessors(size_t state, size_t symbol) const;
+        const word_t* GetChunkTable(size_t symbol, size_t chunk, size_t value) const;
+
+        bool AcceptsSingleWord(std::string_view input) const;
+};
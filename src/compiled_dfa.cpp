@@ -0,0 +1,636 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "compiled_dfa.hpp"
+
+namespace
+{
+    const CompiledDFA::state_t Dead_state = 0;
+
+    // Checking for an accelerated or the dead state after every byte costs
+    // more than it saves.
+    const size_t Acceleration_check_period = 16;
+
+    // Shorter inputs don't pay off the search setup.
+    const size_t Min_accelerated_size = 64;
+
+    // Inputs run interleaved at once by the batch functions.
+    const size_t Batch_size = 256;
+
+    using find_function_t = const char* (*)(const CompiledDFA::Accelerator &, const char *, const char *);
+
+    bool IsInClass(const CompiledDFA::Accelerator &accelerator, uint8_t byte)
+    {
+        auto &masks = byte < 0x80 ? accelerator.low_half_masks : accelerator.high_half_masks;
+        return (masks[byte & 0x0F] >> ((byte >> 4) & 0x07)) & 1;
+    }
+
+    const char* FindBytesScalar(const CompiledDFA::Accelerator &accelerator, const char *position, const char *end)
+    {
+        for (; position != end; ++position)
+        {
+            auto byte = static_cast<uint8_t>(*position);
+            for (size_t index = 0; index < accelerator.size; ++index)
+            {
+                if (byte == accelerator.bytes[index])
+                    return position;
+            }
+        }
+
+        return end;
+    }
+
+    const char* FindClassScalar(const CompiledDFA::Accelerator &accelerator, const char *position, const char *end)
+    {
+        while (position != end && !IsInClass(accelerator, static_cast<uint8_t>(*position)))
+            ++position;
+
+        return position;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // Unused slots of the accelerator repeat its first byte.
+    __attribute__((target("sse2")))
+    const char* FindBytesSSE2(const CompiledDFA::Accelerator &accelerator, const char *position, const char *end)
+    {
+        const size_t Vector_size = sizeof(__m128i);
+
+        __m128i first = _mm_set1_epi8(static_cast<char>(accelerator.bytes[0]));
+        __m128i second = _mm_set1_epi8(static_cast<char>(accelerator.bytes[accelerator.size > 1 ? 1 : 0]));
+        __m128i third = _mm_set1_epi8(static_cast<char>(accelerator.bytes[accelerator.size > 2 ? 2 : 0]));
+
+        for (; static_cast<size_t>(end - position) >= Vector_size; position += Vector_size)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+            __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, first), _mm_cmpeq_epi8(block, second)),
+                                         _mm_cmpeq_epi8(block, third));
+
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(found));
+            if (mask != 0)
+                return position + __builtin_ctz(mask);
+        }
+
+        return FindBytesScalar(accelerator, position, end);
+    }
+
+    __attribute__((target("avx2")))
+    const char* FindBytesAVX2(const CompiledDFA::Accelerator &accelerator, const char *position, const char *end)
+    {
+        const size_t Vector_size = sizeof(__m256i);
+
+        __m256i first = _mm256_set1_epi8(static_cast<char>(accelerator.bytes[0]));
+        __m256i second = _mm256_set1_epi8(static_cast<char>(accelerator.bytes[accelerator.size > 1 ? 1 : 0]));
+        __m256i third = _mm256_set1_epi8(static_cast<char>(accelerator.bytes[accelerator.size > 2 ? 2 : 0]));
+
+        for (; static_cast<size_t>(end - position) >= Vector_size; position += Vector_size)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(position));
+            __m256i found = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, first), _mm256_cmpeq_epi8(block, second)),
+                                            _mm256_cmpeq_epi8(block, third));
+
+            auto mask = static_cast<unsigned>(_mm256_movemask_epi8(found));
+            if (mask != 0)
+                return position + __builtin_ctz(mask);
+        }
+
+        return FindBytesSSE2(accelerator, position, end);
+    }
+
+    // The low nibble of a byte selects a mask of its half of the byte range
+    // and the upper bits select the bit; a shuffle on a byte with the high bit
+    // set gives 0, which rules out the other half.
+    __attribute__((target("ssse3")))
+    const char* FindClassSSSE3(const CompiledDFA::Accelerator &accelerator, const char *position, const char *end)
+    {
+        const size_t Vector_size = sizeof(__m128i);
+
+        __m128i low_half_masks = _mm_loadu_si128(reinterpret_cast<const __m128i *>(accelerator.low_half_masks));
+        __m128i high_half_masks = _mm_loadu_si128(reinterpret_cast<const __m128i *>(accelerator.high_half_masks));
+        __m128i high_bit = _mm_set1_epi8(static_cast<char>(0x80));
+        __m128i bits = _mm_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+
+        for (; static_cast<size_t>(end - position) >= Vector_size; position += Vector_size)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+            __m128i masks = _mm_or_si128(_mm_shuffle_epi8(low_half_masks, block),
+                                         _mm_shuffle_epi8(high_half_masks, _mm_xor_si128(block, high_bit)));
+            __m128i bit = _mm_shuffle_epi8(bits, _mm_andnot_si128(high_bit, _mm_srli_epi64(block, 4)));
+            __m128i outside = _mm_cmpeq_epi8(_mm_and_si128(masks, bit), _mm_setzero_si128());
+
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(outside)) ^ 0xFFFFu;
+            if (mask != 0)
+                return position + __builtin_ctz(mask);
+        }
+
+        return FindClassScalar(accelerator, position, end);
+    }
+
+    __attribute__((target("avx2")))
+    const char* FindClassAVX2(const CompiledDFA::Accelerator &accelerator, const char *position, const char *end)
+    {
+        const size_t Vector_size = sizeof(__m256i);
+
+        __m256i low_half_masks = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(accelerator.low_half_masks)));
+        __m256i high_half_masks = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(accelerator.high_half_masks)));
+        __m256i high_bit = _mm256_set1_epi8(static_cast<char>(0x80));
+        __m256i bits = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+
+        for (; static_cast<size_t>(end - position) >= Vector_size; position += Vector_size)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(position));
+            __m256i masks = _mm256_or_si256(_mm256_shuffle_epi8(low_half_masks, block),
+                                            _mm256_shuffle_epi8(high_half_masks, _mm256_xor_si256(block, high_bit)));
+            __m256i bit = _mm256_shuffle_epi8(bits, _mm256_andnot_si256(high_bit, _mm256_srli_epi64(block, 4)));
+            __m256i outside = _mm256_cmpeq_epi8(_mm256_and_si256(masks, bit), _mm256_setzero_si256());
+
+            auto mask = ~static_cast<unsigned>(_mm256_movemask_epi8(outside));
+            if (mask != 0)
+                return position + __builtin_ctz(mask);
+        }
+
+        return FindClassSSSE3(accelerator, position, end);
+    }
+
+    void ChooseFindFunctions(find_function_t &find_bytes, find_function_t &find_class)
+    {
+        __builtin_cpu_init();
+        find_bytes = FindBytesSSE2;
+        find_class = FindClassScalar;
+
+        if (__builtin_cpu_supports("ssse3"))
+            find_class = FindClassSSSE3;
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            find_bytes = FindBytesAVX2;
+            find_class = FindClassAVX2;
+        }
+    }
+#else
+    void ChooseFindFunctions(find_function_t &find_bytes, find_function_t &find_class)
+    {
+        find_bytes = FindBytesScalar;
+        find_class = FindClassScalar;
+    }
+#endif
+
+    struct FindFunctions
+    {
+        find_function_t find_bytes = FindBytesScalar;
+        find_function_t find_class = FindClassScalar;
+
+        FindFunctions() { ChooseFindFunctions(find_bytes, find_class); }
+    };
+
+    // Chosen on the first use, so scanning works during static initialization.
+    const FindFunctions& GetFindFunctions()
+    {
+        static const FindFunctions find_functions;
+        return find_functions;
+    }
+
+    // A state is accelerated if it loops on most letters of the alphabet.
+    // Bytes out of the alphabet lead to the dead state, so they leave it too.
+    CompiledDFA::Accelerator GetAccelerator(const std::vector<CompiledDFA::state_t> &table, CompiledDFA::state_t state,
+                                            const std::vector<uint8_t> &byte_classes,
+                                            const std::vector<uint8_t> &is_letter, size_t number_of_letters)
+    {
+        CompiledDFA::Accelerator accelerator = {};
+
+        std::vector<uint8_t> exits;
+        size_t number_of_loops = 0;
+        for (size_t byte = 0; byte < CompiledDFA::Number_of_bytes; ++byte)
+        {
+            if (table[state + byte_classes[byte]] != state)
+                exits.push_back(static_cast<uint8_t>(byte));
+            else
+                number_of_loops += is_letter[byte];
+        }
+
+        if (exits.size() <= CompiledDFA::Max_accelerated_bytes)
+        {
+            accelerator.size = static_cast<uint8_t>(exits.size());
+            std::copy(exits.begin(), exits.end(), accelerator.bytes);
+
+            return accelerator;
+        }
+
+        if (2 * number_of_loops <= number_of_letters)
+        {
+            accelerator.size = CompiledDFA::Accelerator::Not_accelerated;
+            return accelerator;
+        }
+
+        accelerator.size = CompiledDFA::Accelerator::Byte_class;
+        for (auto byte : exits)
+        {
+            auto &masks = byte < 0x80 ? accelerator.low_half_masks : accelerator.high_half_masks;
+            masks[byte & 0x0F] |= static_cast<uint8_t>(1 << ((byte >> 4) & 0x07));
+        }
+
+        return accelerator;
+    }
+
+    // Bytes of the alphabet get the classes of their symbols, numbered in the
+    // order of their smallest bytes; the other bytes share one more class.
+    // Sets the symbol of every class, or NoSymbol for the other bytes.
+    size_t GetByteClasses(const DenseDFA &automaton, std::vector<uint8_t> &byte_classes, std::vector<size_t> &class_symbols)
+    {
+        const size_t No_symbol = std::numeric_limits<size_t>::max();
+
+        std::vector<uint32_t> symbol_classes;
+        std::vector<size_t> byte_class_of_symbol_class(automaton.GetSymbolClasses(symbol_classes), No_symbol);
+
+        std::vector<size_t> symbol_of_byte(CompiledDFA::Number_of_bytes, No_symbol);
+        auto &alphabet = automaton.GetAlphabet();
+        for (size_t symbol = 0; symbol < alphabet.size(); ++symbol)
+        {
+            if (alphabet[symbol] >= 0 && static_cast<size_t>(alphabet[symbol]) < CompiledDFA::Number_of_bytes)
+                symbol_of_byte[static_cast<size_t>(alphabet[symbol])] = symbol;
+        }
+
+        byte_classes.assign(CompiledDFA::Number_of_bytes, 0);
+        class_symbols.clear();
+        size_t other_bytes_class = No_symbol;
+
+        for (size_t byte = 0; byte < CompiledDFA::Number_of_bytes; ++byte)
+        {
+            size_t symbol = symbol_of_byte[byte];
+            size_t &byte_class = symbol == No_symbol ? other_bytes_class : byte_class_of_symbol_class[symbol_classes[symbol]];
+
+            if (byte_class == No_symbol)
+            {
+                byte_class = class_symbols.size();
+                class_symbols.push_back(symbol);
+            }
+
+            byte_classes[byte] = static_cast<uint8_t>(byte_class);
+        }
+
+        return class_symbols.size();
+    }
+
+    struct CompiledTables
+    {
+        std::vector<uint8_t> byte_classes;
+        std::vector<CompiledDFA::state_t> table;
+        std::vector<uint8_t> accepting;
+        std::vector<CompiledDFA::Accelerator> acceleration;
+
+        std::vector<uint32_t> accept_offsets;
+        std::vector<uint32_t> accept_ids;
+    };
+};
+
+CompiledDFA::CompiledDFA(const Automaton &automaton):
+    storage_(),
+    byte_classes_(),
+    row_shift_(0),
+    table_(),
+    accepting_(),
+    acceleration_(),
+    start_state_(Dead_state),
+    accept_offsets_(),
+    accept_ids_()
+{
+    Compile(DenseDFA(automaton));
+}
+
+CompiledDFA::CompiledDFA(const DenseDFA &automaton):
+    storage_(),
+    byte_classes_(),
+    row_shift_(0),
+    table_(),
+    accepting_(),
+    acceleration_(),
+    start_state_(Dead_state),
+    accept_offsets_(),
+    accept_ids_()
+{
+    Compile(automaton);
+}
+
+void CompiledDFA::Compile(const DenseDFA &automaton)
+{
+    auto tables = std::make_shared<CompiledTables>();
+    auto &byte_classes = tables->byte_classes;
+    auto &table = tables->table;
+    auto &accepting = tables->accepting;
+    auto &acceleration = tables->acceleration;
+    auto &accept_offsets = tables->accept_offsets;
+    auto &accept_ids = tables->accept_ids;
+
+    std::vector<uint8_t> is_letter(Number_of_bytes, false);
+    size_t number_of_letters = 0;
+    for (auto letter : automaton.GetAlphabet())
+    {
+        if (letter >= 0 && static_cast<size_t>(letter) < Number_of_bytes)
+        {
+            is_letter[static_cast<size_t>(letter)] = true;
+            ++number_of_letters;
+        }
+    }
+
+    auto share_tables = [&]()
+    {
+        acceleration.resize(accepting.size());
+        for (size_t compiled_state = 0; compiled_state < accepting.size(); ++compiled_state)
+        {
+            acceleration[compiled_state] = GetAccelerator(table, static_cast<state_t>(compiled_state << row_shift_),
+                                                          byte_classes, is_letter, number_of_letters);
+        }
+
+        byte_classes_ = byte_classes;
+        table_ = table;
+        accepting_ = accepting;
+        acceleration_ = acceleration;
+        accept_offsets_ = accept_offsets;
+        accept_ids_ = accept_ids;
+        storage_ = std::move(tables);
+    };
+
+    size_t number_of_states = automaton.GetNumberOfStates();
+    auto &alphabet = automaton.GetAlphabet();
+
+    std::vector<size_t> class_symbols;
+    size_t number_of_classes = GetByteClasses(automaton, byte_classes, class_symbols);
+
+    row_shift_ = 0;
+    while ((size_t(1) << row_shift_) < number_of_classes)
+        ++row_shift_;
+
+    size_t row_size = size_t(1) << row_shift_;
+
+    // Non-final states looping on every letter are merged into the dead state.
+    std::vector<state_t> compiled_states(number_of_states, Dead_state);
+    size_t number_of_compiled_states = 1;
+
+    for (DenseDFA::state_t state = 0; state < number_of_states; ++state)
+    {
+        bool is_dead = !automaton.IsStateFinal(state);
+        for (auto target : automaton.GetRow(state))
+            is_dead = is_dead && target == state;
+
+        if (!is_dead)
+            compiled_states[state] = static_cast<state_t>(number_of_compiled_states++ << row_shift_);
+    }
+
+    if (number_of_compiled_states > std::numeric_limits<state_t>::max() / row_size)
+    {
+        std::cerr << "Automaton has too many states to be compiled. It was compiled as an empty language.\n";
+        table.assign(row_size, Dead_state);
+        accepting.assign(1, false);
+        share_tables();
+        return;
+    }
+
+    table.assign(number_of_compiled_states << row_shift_, Dead_state);
+    accepting.assign(number_of_compiled_states, false);
+    start_state_ = compiled_states[automaton.GetStartState()];
+
+    if (automaton.HasAcceptIds())
+        accept_offsets.assign(number_of_compiled_states + 1, 0);
+
+    bool has_wide_symbols = false;
+    for (DenseDFA::state_t state = 0; state < number_of_states; ++state)
+    {
+        state_t compiled_state = compiled_states[state];
+        if (compiled_state == Dead_state)
+            continue;
+
+        accepting[compiled_state >> row_shift_] = automaton.IsStateFinal(state);
+        if (automaton.HasAcceptIds() && automaton.IsStateFinal(state))
+            accept_offsets[(compiled_state >> row_shift_) + 1] = static_cast<uint32_t>(automaton.GetAcceptIds(state).size());
+
+        for (size_t byte_class = 0; byte_class < number_of_classes; ++byte_class)
+        {
+            if (class_symbols[byte_class] >= alphabet.size())
+                continue;
+
+            auto target = automaton.GetTransition(state, class_symbols[byte_class]);
+            if (target != DenseDFA::NoState)
+                table[compiled_state + byte_class] = compiled_states[target];
+        }
+    }
+
+    for (auto letter : alphabet)
+        has_wide_symbols = has_wide_symbols || letter < 0 || static_cast<size_t>(letter) >= Number_of_bytes;
+
+    // Compiled states are numbered in the order of the original ones, so the
+    // IDs appended in that order match the offsets.
+    for (size_t compiled_state = 1; compiled_state < accept_offsets.size(); ++compiled_state)
+        accept_offsets[compiled_state] += accept_offsets[compiled_state - 1];
+
+    accept_ids.reserve(accept_offsets.empty() ? 0 : accept_offsets.back());
+    for (DenseDFA::state_t state = 0; state < number_of_states && !accept_offsets.empty(); ++state)
+    {
+        if (compiled_states[state] == Dead_state || !automaton.IsStateFinal(state))
+            continue;
+
+        for (auto id : automaton.GetAcceptIds(state))
+            accept_ids.push_back(static_cast<uint32_t>(id));
+    }
+
+    share_tables();
+
+    if (has_wide_symbols)
+        std::cerr << "Letters out of the byte range can't be matched and were ignored.\n";
+}
+
+bool CompiledDFA::Accepts(std::string_view input) const { return IsAccepting(Run(start_state_, input)); }
+
+void CompiledDFA::AcceptsBatch(std::span<const std::string_view> inputs, std::span<uint8_t> results) const
+{
+    state_t states[Batch_size];
+    size_t number_of_inputs = std::min(inputs.size(), results.size());
+
+    for (size_t first = 0; first < number_of_inputs; first += Batch_size)
+    {
+        size_t batch_size = std::min(Batch_size, number_of_inputs - first);
+        RunInterleaved(inputs.subspan(first, batch_size), std::span<state_t>(states, batch_size));
+
+        for (size_t index = 0; index < batch_size; ++index)
+            results[first + index] = IsAccepting(states[index]);
+    }
+}
+
+size_t CompiledDFA::CountAccepted(std::span<const std::string_view> inputs) const
+{
+    state_t states[Batch_size];
+    size_t accepted = 0;
+
+    for (size_t first = 0; first < inputs.size(); first += Batch_size)
+    {
+        size_t batch_size = std::min(Batch_size, inputs.size() - first);
+        RunInterleaved(inputs.subspan(first, batch_size), std::span<state_t>(states, batch_size));
+
+        for (size_t index = 0; index < batch_size; ++index)
+            accepted += IsAccepting(states[index]);
+    }
+
+    return accepted;
+}
+
+std::span<const uint32_t> CompiledDFA::Match(std::string_view input) const { return GetAcceptIds(Run(start_state_, input)); }
+
+CompiledDFA::state_t CompiledDFA::Run(state_t state, std::string_view input) const
+{
+    const state_t *table = table_.data();
+    const uint8_t *byte_classes = byte_classes_.data();
+    const char *position = input.data();
+    const char *end = position + input.size();
+
+    if (input.size() < Min_accelerated_size)
+    {
+        for (; position != end; ++position)
+            state = table[state + byte_classes[static_cast<unsigned char>(*position)]];
+
+        return state;
+    }
+
+    while (position != end)
+    {
+        position = Skip(state, position, end);
+
+        size_t block_size = std::min(Acceleration_check_period, static_cast<size_t>(end - position));
+        for (size_t index = 0; index < block_size; ++index)
+            state = table[state + byte_classes[static_cast<unsigned char>(position[index])]];
+
+        position += block_size;
+    }
+
+    return state;
+}
+
+// Every stream takes the next input as soon as its current one ends, so all
+// of them stay busy until the inputs run out.
+void CompiledDFA::RunInterleaved(std::span<const std::string_view> inputs, std::span<state_t> states) const
+{
+    const state_t *table = table_.data();
+    const uint8_t *byte_classes = byte_classes_.data();
+    size_t number_of_inputs = std::min(inputs.size(), states.size());
+
+    const unsigned char *positions[Interleaved_streams] = {};
+    const unsigned char *ends[Interleaved_streams] = {};
+    state_t stream_states[Interleaved_streams] = {};
+    size_t stream_inputs[Interleaved_streams] = {};
+
+    size_t next_input = 0;
+    auto take_next_input = [&](size_t stream)
+    {
+        for (; next_input < number_of_inputs; ++next_input)
+        {
+            if (inputs[next_input].empty())
+            {
+                states[next_input] = start_state_;
+                continue;
+            }
+
+            positions[stream] = reinterpret_cast<const unsigned char *>(inputs[next_input].data());
+            ends[stream] = positions[stream] + inputs[next_input].size();
+            stream_states[stream] = start_state_;
+            stream_inputs[stream] = next_input++;
+
+            return true;
+        }
+
+        return false;
+    };
+
+    size_t number_of_streams = 0;
+    while (number_of_streams < Interleaved_streams && take_next_input(number_of_streams))
+        ++number_of_streams;
+
+    while (number_of_streams == Interleaved_streams)
+    {
+        size_t steps = static_cast<size_t>(ends[0] - positions[0]);
+        for (size_t stream = 1; stream < Interleaved_streams; ++stream)
+            steps = std::min(steps, static_cast<size_t>(ends[stream] - positions[stream]));
+
+        for (size_t step = 0; step < steps; ++step)
+        {
+            for (size_t stream = 0; stream < Interleaved_streams; ++stream)
+                stream_states[stream] = table[stream_states[stream] + byte_classes[positions[stream][step]]];
+        }
+
+        for (size_t stream = 0; stream < number_of_streams; ++stream)
+        {
+            positions[stream] += steps;
+            if (positions[stream] != ends[stream])
+                continue;
+
+            states[stream_inputs[stream]] = stream_states[stream];
+            if (take_next_input(stream))
+                continue;
+
+            // The last stream takes the place of the finished one.
+            --number_of_streams;
+            positions[stream] = positions[number_of_streams];
+            ends[stream] = ends[number_of_streams];
+            stream_states[stream] = stream_states[number_of_streams];
+            stream_inputs[stream] = stream_inputs[number_of_streams];
+            --stream;
+        }
+    }
+
+    for (size_t stream = 0; stream < number_of_streams; ++stream)
+    {
+        auto rest = std::string_view(reinterpret_cast<const char *>(positions[stream]), static_cast<size_t>(ends[stream] - positions[stream]));
+        states[stream_inputs[stream]] = Run(stream_states[stream], rest);
+    }
+}
+
+CompiledDFA::state_t CompiledDFA::GetStartState() const { return start_state_; }
+
+CompiledDFA::state_t CompiledDFA::GetDeadState() const { return Dead_state; }
+
+std::span<const uint32_t> CompiledDFA::GetAcceptIds(state_t state) const
+{
+    if (accept_offsets_.empty())
+        return {};
+
+    size_t compiled_state = state >> row_shift_;
+    return {accept_ids_.data() + accept_offsets_[compiled_state],
+            accept_offsets_[compiled_state + 1] - accept_offsets_[compiled_state]};
+}
+
+size_t CompiledDFA::GetNumberOfStates() const { return accepting_.size(); }
+
+size_t CompiledDFA::GetNumberOfByteClasses() const
+{
+    return byte_classes_.empty() ? 0 : size_t(*std::max_element(byte_classes_.begin(), byte_classes_.end())) + 1;
+}
+
+size_t CompiledDFA::GetRowSize() const { return size_t(1) << row_shift_; }
+
+size_t CompiledDFA::GetNumberOfAcceleratedStates() const
+{
+    return static_cast<size_t>(std::count_if(acceleration_.begin(), acceleration_.end(), [](const Accelerator &accelerator)
+    {
+        return accelerator.size != Accelerator::Not_accelerated;
+    }));
+}
+
+const char* CompiledDFA::FindAnyOf(const Accelerator &accelerator, const char *position, const char *end)
+{
+    if (accelerator.size == Accelerator::Byte_class)
+        return GetFindFunctions().find_class(accelerator, position, end);
+
+    if (accelerator.size == 0)
+        return end;
+
+    if (accelerator.size == 1)
+    {
+        auto *found = std::memchr(position, accelerator.bytes[0], static_cast<size_t>(end - position));
+        return found ? static_cast<const char *>(found) : end;
+    }
+
+    return GetFindFunctions().find_bytes(accelerator, position, end);
+}
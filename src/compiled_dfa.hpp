@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "automaton.hpp"
+#include "flat_automaton.hpp"
+
+// Byte-driven executor of a DFA. Bytes are mapped to classes of bytes with
+// the same transitions in every state, every state owns a row of next states
+// per class, and states are stored premultiplied by the row size, so one step
+// of the scanner is two independent table loads. Rows are padded to a power of
+// two. Bytes which are not in the alphabet of the automaton lead to the dead
+// state. A DFA built from several patterns keeps
+// the accept IDs of its states, so one run reports every matching pattern.
+// The tables are immutable and shared between copies; a DFA loaded by
+// AutomatonSerializer uses them in place in the mapped file.
+//
+// States looping on most letters of the alphabet are accelerated: instead of
+// stepping through the bytes which keep the state the scanner searches for
+// the next byte leaving it with SIMD instructions.
+class CompiledDFA;
+
+namespace AutomatonSerializer
+{
+    bool Save(const CompiledDFA &automaton, const std::string &path);
+    bool Load(const std::string &path, CompiledDFA &automaton, bool verify);
+};
+
+class CompiledDFA
+{
+    public:
+        using state_t = uint32_t;
+
+        static const size_t Number_of_bytes = 256;
+        static const size_t Max_accelerated_bytes = 3;
+        static const size_t Interleaved_streams = 4;
+
+        // Bytes leaving an accelerated state: up to Max_accelerated_bytes
+        // listed bytes, or any set as a bitmap split by the low nibble of the
+        // byte, with a bit for each of the 8 values of the upper bits.
+        struct Accelerator
+        {
+            static const uint8_t Not_accelerated = 0xFF;
+            static const uint8_t Byte_class = 0xFE;
+
+            uint8_t size;
+            uint8_t bytes[Max_accelerated_bytes];
+
+            uint8_t low_half_masks[16];
+            uint8_t high_half_masks[16];
+        };
+
+        explicit CompiledDFA(const Automaton &automaton);
+        explicit CompiledDFA(const DenseDFA &automaton);
+
+        bool Accepts(std::string_view input) const;
+        void AcceptsBatch(std::span<const std::string_view> inputs, std::span<uint8_t> results) const;
+        size_t CountAccepted(std::span<const std::string_view> inputs) const;
+
+        // IDs of the patterns accepting the whole input.
+        std::span<const uint32_t> Match(std::string_view input) const;
+
+        // Calls on_match(end, ids) for every prefix input[0, end) that ends in
+        // an accepting state.
+        template <class callback_t>
+        void Scan(std::string_view input, callback_t &&on_match) const
+        {
+            state_t state = start_state_;
+            if (IsAccepting(state))
+                on_match(size_t(0), GetAcceptIds(state));
+
+            const char *begin = input.data();
+            const char *end = begin + input.size();
+            for (const char *position = begin; position != end; ++position)
+            {
+                if (!IsAccepting(state))
+                {
+                    position = Skip(state, position, end);
+                    if (position == end)
+                        break;
+                }
+
+                state = Step(state, static_cast<unsigned char>(*position));
+                if (IsAccepting(state))
+                    on_match(static_cast<size_t>(position - begin) + 1, GetAcceptIds(state));
+            }
+        }
+
+        state_t Run(state_t state, std::string_view input) const;
+        state_t Step(state_t state, unsigned char byte) const { return table_[state + byte_classes_[byte]]; }
+
+        // Runs the inputs from the start state in lockstep, so the table loads
+        // of different inputs overlap. Writes the final state of every input.
+        void RunInterleaved(std::span<const std::string_view> inputs, std::span<state_t> states) const;
+
+        // First position in [position, end) where the state can change, or
+        // position itself if the state is not accelerated.
+        const char* Skip(state_t state, const char *position, const char *end) const
+        {
+            auto &accelerator = acceleration_[state >> row_shift_];
+            if (accelerator.size == Accelerator::Not_accelerated)
+                return position;
+
+            return FindAnyOf(accelerator, position, end);
+        }
+
+        state_t GetStartState() const;
+        state_t GetDeadState() const;
+        bool IsAccepting(state_t state) const { return accepting_[state >> row_shift_]; }
+        std::span<const uint32_t> GetAcceptIds(state_t state) const;
+
+        size_t GetNumberOfStates() const;
+        size_t GetNumberOfByteClasses() const;
+        size_t GetRowSize() const;
+        size_t GetNumberOfAcceleratedStates() const;
+
+        friend bool AutomatonSerializer::Save(const CompiledDFA &automaton, const std::string &path);
+        friend bool AutomatonSerializer::Load(const std::string &path, CompiledDFA &automaton, bool verify);
+
+    private:
+        // Owns the memory the tables point to: vectors of a compiled DFA or
+        // the mapping of a loaded one.
+        std::shared_ptr<const void> storage_;
+
+        std::span<const uint8_t> byte_classes_;
+        size_t row_shift_ = 0;
+
+        std::span<const state_t> table_;
+        std::span<const uint8_t> accepting_;
+        std::span<const Accelerator> acceleration_;
+        state_t start_state_ = 0;
+
+        std::span<const uint32_t> accept_offsets_;
+        std::span<const uint32_t> accept_ids_;
+
+        void Compile(const DenseDFA &automaton);
+
+        static const char* FindAnyOf(const Accelerator &accelerator, const char *position, const char *end);
+};
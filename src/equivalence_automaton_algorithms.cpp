@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+#include "automaton_algorithms.hpp"
+#include "subset_table.hpp"
+
+namespace
+{
+    const uint32_t No_parent = std::numeric_limits<uint32_t>::max();
+
+    // Pair of states reached by a breadth-first search together with the
+    // edge it was reached by, so the word leading to it can be restored.
+    struct SearchNode
+    {
+        uint32_t first;
+        uint32_t second;
+
+        uint32_t parent;
+        uint32_t symbol;
+    };
+
+    void RestoreWord(const std::vector<SearchNode> &nodes, uint32_t node, const std::vector<Automaton::alpha_t> &alphabet,
+                     std::vector<Automaton::alpha_t> *word)
+    {
+        if (!word)
+            return;
+
+        word->clear();
+        for (; nodes[node].parent != No_parent; node = nodes[node].parent)
+            word->push_back(alphabet[nodes[node].symbol]);
+
+        std::reverse(word->begin(), word->end());
+    }
+
+    std::vector<Automaton::alpha_t> GetCommonAlphabet(const std::vector<Automaton::alpha_t> &first,
+                                                      const std::vector<Automaton::alpha_t> &second)
+    {
+        std::vector<Automaton::alpha_t> alphabet;
+        std::set_union(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(alphabet));
+
+        return alphabet;
+    }
+
+    class UnionFind
+    {
+        public:
+            explicit UnionFind(size_t size):
+                parents_(size),
+                sizes_(size, 1)
+            {
+                for (uint32_t element = 0; element < size; ++element)
+                    parents_[element] = element;
+            }
+
+            uint32_t Find(uint32_t element)
+            {
+                while (parents_[element] != element)
+                {
+                    parents_[element] = parents_[parents_[element]];
+                    element = parents_[element];
+                }
+
+                return element;
+            }
+
+            void Unite(uint32_t first, uint32_t second)
+            {
+                if (sizes_[first] < sizes_[second])
+                    std::swap(first, second);
+
+                parents_[second] = first;
+                sizes_[first] += sizes_[second];
+            }
+
+        private:
+            std::vector<uint32_t> parents_;
+            std::vector<uint32_t> sizes_;
+    };
+
+    // States of both automata and a shared sink numbered in one range. The
+    // sink replaces missing transitions and letters out of an alphabet.
+    class DisjointDFAUnion
+    {
+        public:
+            DisjointDFAUnion(const DenseDFA &first, const DenseDFA &second, const std::vector<Automaton::alpha_t> &alphabet):
+                first_(first),
+                second_(second),
+                first_symbols_(),
+                second_symbols_(),
+                sink_(static_cast<uint32_t>(first.GetNumberOfStates() + second.GetNumberOfStates()))
+            {
+                for (auto letter : alphabet)
+                {
+                    first_symbols_.push_back(GetSymbol(first, letter));
+                    second_symbols_.push_back(GetSymbol(second, letter));
+                }
+            }
+
+            size_t Size() const { return sink_ + 1; }
+            uint32_t GetFirstState(DenseDFA::state_t state) const { return state; }
+            uint32_t GetSecondState(DenseDFA::state_t state) const { return static_cast<uint32_t>(first_.GetNumberOfStates()) + state; }
+
+            bool IsFinal(uint32_t state) const
+            {
+                if (state == sink_)
+                    return false;
+
+                if (state < first_.GetNumberOfStates())
+                    return first_.IsStateFinal(state);
+
+                return second_.IsStateFinal(state - static_cast<uint32_t>(first_.GetNumberOfStates()));
+            }
+
+            uint32_t Step(uint32_t state, size_t symbol) const
+            {
+                if (state == sink_)
+                    return sink_;
+
+                if (state < first_.GetNumberOfStates())
+                {
+                    if (first_symbols_[symbol] == FlatAutomaton::NoSymbol)
+                        return sink_;
+
+                    auto target = first_.GetTransition(state, first_symbols_[symbol]);
+                    return target == DenseDFA::NoState ? sink_ : GetFirstState(target);
+                }
+
+                auto second_state = state - static_cast<uint32_t>(first_.GetNumberOfStates());
+                if (second_symbols_[symbol] == FlatAutomaton::NoSymbol)
+                    return sink_;
+
+                auto target = second_.GetTransition(second_state, second_symbols_[symbol]);
+                return target == DenseDFA::NoState ? sink_ : GetSecondState(target);
+            }
+
+        private:
+            const DenseDFA &first_;
+            const DenseDFA &second_;
+
+            std::vector<size_t> first_symbols_;
+            std::vector<size_t> second_symbols_;
+
+            uint32_t sink_;
+
+            static size_t GetSymbol(const DenseDFA &automaton, Automaton::alpha_t letter)
+            {
+                auto &alphabet = automaton.GetAlphabet();
+                auto position = std::lower_bound(alphabet.begin(), alphabet.end(), letter);
+                if (position == alphabet.end() || *position != letter)
+                    return FlatAutomaton::NoSymbol;
+
+                return static_cast<size_t>(position - alphabet.begin());
+            }
+    };
+
+    bool IsSubset(std::span<const size_t> subset, std::span<const size_t> set)
+    {
+        return std::includes(set.begin(), set.end(), subset.begin(), subset.end());
+    }
+
+    bool IsDeterministic(const Automaton &automaton)
+    {
+        for (auto state : automaton.GetStateNumbers())
+        {
+            for (auto &alpha_neigh : automaton.GetNeighbours(state))
+            {
+                if (alpha_neigh.first == Automaton::Epsilon || alpha_neigh.second.size() > 1)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    FlatAutomaton GetEpsilonFreeFlat(const Automaton &automaton)
+    {
+        for (auto state : automaton.GetStateNumbers())
+        {
+            if (automaton.CanTransit(state, Automaton::Epsilon))
+            {
+                Automaton epsilon_free = automaton;
+                AutomatonTransformer::RemoveEpsTransitions(epsilon_free);
+
+                return FlatAutomaton(epsilon_free);
+            }
+        }
+
+        return FlatAutomaton(automaton);
+    }
+
+    // Antichain inclusion check: the search runs over pairs of a state of the
+    // included automaton and a subset of states of the including one. A pair
+    // is dropped if another pair with the same state and a smaller subset was
+    // already seen, since every word accepted from the dropped pair but not
+    // from its subset is also accepted from the other pair but not from its
+    // subset. The search is breadth-first, so the counterexample is shortest.
+    bool IncludesFlat(const FlatAutomaton &first, const FlatAutomaton &second, std::vector<Automaton::alpha_t> *counterexample)
+    {
+        auto alphabet = GetCommonAlphabet(first.GetAlphabet(), second.GetAlphabet());
+
+        std::vector<FlatAutomaton::symbol_t> first_symbols;
+        std::vector<FlatAutomaton::symbol_t> second_symbols;
+        for (auto letter : alphabet)
+        {
+            first_symbols.push_back(first.GetSymbol(letter));
+            second_symbols.push_back(second.GetSymbol(letter));
+        }
+
+        SubsetTable subsets;
+        std::vector<SearchNode> nodes;
+        std::vector<std::vector<uint32_t>> antichains(second.GetNumberOfStates());
+
+        auto is_rejecting = [&first, &subsets](uint32_t subset)
+        {
+            auto states = subsets.GetSubset(subset);
+            return std::none_of(states.begin(), states.end(),
+                                [&first](size_t state) { return first.IsStateFinal(static_cast<FlatAutomaton::state_t>(state)); });
+        };
+
+        // Returns false if the pair is subsumed by an already seen one.
+        auto add_to_antichain = [&subsets, &antichains](uint32_t state, uint32_t subset)
+        {
+            auto &antichain = antichains[state];
+            auto states = subsets.GetSubset(subset);
+
+            for (auto other : antichain)
+            {
+                if (IsSubset(subsets.GetSubset(other), states))
+                    return false;
+            }
+
+            std::erase_if(antichain, [&](uint32_t other) { return IsSubset(states, subsets.GetSubset(other)); });
+            antichain.push_back(subset);
+
+            return true;
+        };
+
+        std::vector<size_t> start_subset = {first.GetStartState()};
+        auto start_index = static_cast<uint32_t>(subsets.Insert(start_subset, false));
+        add_to_antichain(second.GetStartState(), start_index);
+        nodes.push_back({start_index, second.GetStartState(), No_parent, 0});
+
+        std::vector<size_t> visit_marks(first.GetNumberOfStates(), 0);
+        size_t current_mark = 0;
+        std::vector<size_t> new_subset;
+
+        for (uint32_t node = 0; node < nodes.size(); ++node)
+        {
+            auto [subset, state, parent, symbol] = nodes[node];
+            if (second.IsStateFinal(state) && is_rejecting(subset))
+            {
+                RestoreWord(nodes, node, alphabet, counterexample);
+                return false;
+            }
+
+            for (uint32_t letter = 0; letter < alphabet.size(); ++letter)
+            {
+                if (second_symbols[letter] == FlatAutomaton::NoSymbol)
+                    continue;
+
+                auto targets = second.GetTargets(state, second_symbols[letter]);
+                if (targets.empty())
+                    continue;
+
+                ++current_mark;
+                new_subset.clear();
+                if (first_symbols[letter] != FlatAutomaton::NoSymbol)
+                {
+                    for (auto first_state : subsets.GetSubset(subset))
+                    {
+                        for (auto target : first.GetTargets(static_cast<FlatAutomaton::state_t>(first_state), first_symbols[letter]))
+                        {
+                            if (visit_marks[target] != current_mark)
+                            {
+                                visit_marks[target] = current_mark;
+                                new_subset.push_back(target);
+                            }
+                        }
+                    }
+                }
+
+                std::sort(new_subset.begin(), new_subset.end());
+                auto new_index = static_cast<uint32_t>(subsets.Insert(new_subset, false));
+
+                for (auto target : targets)
+                {
+                    if (add_to_antichain(target, new_index))
+                        nodes.push_back({new_index, target, node, letter});
+                }
+            }
+        }
+
+        return true;
+    }
+};
+
+// Hopcroft-Karp: the states of both automata are kept in a union-find, and a
+// pair reached by a word is skipped if its states already are in one class.
+// Every explored pair merges two classes, so the search is almost linear in
+// the sizes of the automata. Pairs are merged breadth-first, so the first pair
+// with different finality gives a shortest counterexample.
+bool AutomatonTransformer::Equivalent(const DenseDFA &first, const DenseDFA &second,
+                                      std::vector<Automaton::alpha_t> *counterexample)
+{
+    auto alphabet = GetCommonAlphabet(first.GetAlphabet(), second.GetAlphabet());
+    DisjointDFAUnion states(first, second, alphabet);
+    UnionFind classes(states.Size());
+
+    std::vector<SearchNode> nodes;
+    nodes.push_back({states.GetFirstState(first.GetStartState()), states.GetSecondState(second.GetStartState()), No_parent, 0});
+
+    if (states.IsFinal(nodes[0].first) != states.IsFinal(nodes[0].second))
+    {
+        RestoreWord(nodes, 0, alphabet, counterexample);
+        return false;
+    }
+
+    classes.Unite(nodes[0].first, nodes[0].second);
+
+    for (uint32_t node = 0; node < nodes.size(); ++node)
+    {
+        for (uint32_t symbol = 0; symbol < alphabet.size(); ++symbol)
+        {
+            auto first_target = states.Step(nodes[node].first, symbol);
+            auto second_target = states.Step(nodes[node].second, symbol);
+
+            auto first_class = classes.Find(first_target);
+            auto second_class = classes.Find(second_target);
+            if (first_class == second_class)
+                continue;
+
+            nodes.push_back({first_target, second_target, node, symbol});
+            if (states.IsFinal(first_target) != states.IsFinal(second_target))
+            {
+                RestoreWord(nodes, static_cast<uint32_t>(nodes.size() - 1), alphabet, counterexample);
+                return false;
+            }
+
+            classes.Unite(first_class, second_class);
+        }
+    }
+
+    return true;
+}
+
+bool AutomatonTransformer::Equivalent(const Automaton &first, const Automaton &second,
+                                      std::vector<Automaton::alpha_t> *counterexample)
+{
+    if (IsDeterministic(first) && IsDeterministic(second))
+        return Equivalent(DenseDFA(first), DenseDFA(second), counterexample);
+
+    auto first_flat = GetEpsilonFreeFlat(first);
+    auto second_flat = GetEpsilonFreeFlat(second);
+
+    std::vector<Automaton::alpha_t> missing_in_first;
+    std::vector<Automaton::alpha_t> missing_in_second;
+    bool first_includes = IncludesFlat(first_flat, second_flat, &missing_in_first);
+    bool second_includes = IncludesFlat(second_flat, first_flat, &missing_in_second);
+
+    if (counterexample && !first_includes && (second_includes || missing_in_first.size() <= missing_in_second.size()))
+        *counterexample = std::move(missing_in_first);
+    else if (counterexample && !second_includes)
+        *counterexample = std::move(missing_in_second);
+
+    return first_includes && second_includes;
+}
+
+bool AutomatonTransformer::Includes(const Automaton &first, const Automaton &second,
+                                    std::vector<Automaton::alpha_t> *counterexample)
+{
+    return IncludesFlat(GetEpsilonFreeFlat(first), GetEpsilonFreeFlat(second), counterexample);
+}
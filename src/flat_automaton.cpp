@@ -0,0 +1,500 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+#include "flat_automaton.hpp"
+
+namespace
+{
+    // Renumbers labels in the order of their first occurrence.
+    size_t RenumberLabels(std::vector<uint32_t> &labels, size_t number_of_labels)
+    {
+        std::vector<uint32_t> new_labels(number_of_labels, DenseDFA::NoState);
+        size_t number_of_classes = 0;
+
+        for (auto &label : labels)
+        {
+            if (new_labels[label] == DenseDFA::NoState)
+                new_labels[label] = static_cast<uint32_t>(number_of_classes++);
+
+            label = new_labels[label];
+        }
+
+        return number_of_classes;
+    }
+};
+
+const FlatAutomaton::symbol_t FlatAutomaton::NoSymbol = std::numeric_limits<FlatAutomaton::symbol_t>::max();
+const DenseDFA::state_t DenseDFA::NoState = std::numeric_limits<DenseDFA::state_t>::max();
+
+FlatAutomaton::FlatAutomaton(const Automaton &automaton):
+    alphabet_(automaton.GetAlphabet().begin(), automaton.GetAlphabet().end()),
+    offsets_(1, 0),
+    symbols_(),
+    targets_(),
+    final_(),
+    start_state_(0),
+    accept_offsets_(),
+    accept_ids_(),
+    original_states_(automaton.GetStateNumbers().begin(), automaton.GetStateNumbers().end())
+{
+    std::unordered_map<size_t, state_t> to_flat_state;
+    to_flat_state.reserve(original_states_.size());
+    for (size_t state = 0; state < original_states_.size(); ++state)
+        to_flat_state[original_states_[state]] = static_cast<state_t>(state);
+
+    start_state_ = to_flat_state.at(automaton.GetStartState());
+
+    final_.resize(original_states_.size(), false);
+    for (auto final : automaton.GetFinalStates())
+    {
+        if (to_flat_state.contains(final))
+            final_[to_flat_state[final]] = true;
+    }
+
+    offsets_.reserve(original_states_.size() + 1);
+
+    std::vector<std::pair<symbol_t, state_t>> edges;
+    for (auto state : original_states_)
+    {
+        edges.clear();
+        for (auto &alpha_neigh : automaton.GetNeighbours(state))
+        {
+            symbol_t symbol = alpha_neigh.first == Automaton::Epsilon ? GetEpsilonSymbol() : GetSymbol(alpha_neigh.first);
+            if (symbol == NoSymbol)
+                continue;
+
+            for (auto neighbour : alpha_neigh.second)
+                edges.push_back({symbol, to_flat_state.at(neighbour)});
+        }
+
+        std::sort(edges.begin(), edges.end());
+        for (auto &[symbol, target] : edges)
+        {
+            symbols_.push_back(symbol);
+            targets_.push_back(target);
+        }
+
+        offsets_.push_back(static_cast<uint32_t>(targets_.size()));
+    }
+}
+
+FlatAutomaton::FlatAutomaton(const std::vector<Automaton> &patterns):
+    alphabet_(),
+    offsets_(1, 0),
+    symbols_(),
+    targets_(),
+    final_(1, false),
+    start_state_(0),
+    accept_offsets_(1, 0),
+    accept_ids_(),
+    original_states_(1, std::numeric_limits<size_t>::max())
+{
+    std::set<Automaton::alpha_t> alphabet;
+    for (auto &pattern : patterns)
+        alphabet.insert(pattern.GetAlphabet().begin(), pattern.GetAlphabet().end());
+
+    alphabet_.assign(alphabet.begin(), alphabet.end());
+
+    std::vector<FlatAutomaton> flat_patterns;
+    flat_patterns.reserve(patterns.size());
+
+    std::vector<state_t> first_states;
+    first_states.reserve(patterns.size());
+
+    size_t number_of_states = 1;
+    for (auto &pattern : patterns)
+    {
+        flat_patterns.emplace_back(pattern);
+        first_states.push_back(static_cast<state_t>(number_of_states));
+        number_of_states += flat_patterns.back().GetNumberOfStates();
+    }
+
+    auto to_symbol = [this](const FlatAutomaton &pattern, symbol_t symbol)
+    {
+        return symbol == pattern.GetEpsilonSymbol() ? GetEpsilonSymbol() : GetSymbol(pattern.alphabet_[symbol]);
+    };
+
+    // The shared start state gets the edges of the start states of all the
+    // patterns and accepts the patterns which accept the empty word.
+    std::vector<std::pair<symbol_t, state_t>> start_edges;
+    for (uint32_t pattern = 0; pattern < flat_patterns.size(); ++pattern)
+    {
+        auto &flat = flat_patterns[pattern];
+        auto symbols = flat.GetSymbols(flat.GetStartState());
+        auto targets = flat.GetTargets(flat.GetStartState());
+
+        for (size_t edge = 0; edge < targets.size(); ++edge)
+            start_edges.push_back({to_symbol(flat, symbols[edge]), first_states[pattern] + targets[edge]});
+
+        if (flat.IsStateFinal(flat.GetStartState()))
+        {
+            final_[0] = true;
+            accept_ids_.push_back(pattern);
+        }
+    }
+
+    std::sort(start_edges.begin(), start_edges.end());
+    for (auto &[symbol, target] : start_edges)
+    {
+        symbols_.push_back(symbol);
+        targets_.push_back(target);
+    }
+
+    offsets_.push_back(static_cast<uint32_t>(targets_.size()));
+    accept_offsets_.push_back(static_cast<uint32_t>(accept_ids_.size()));
+
+    // Symbols of a pattern map to the union alphabet monotonically, so the
+    // edges stay sorted.
+    offsets_.reserve(number_of_states + 1);
+    final_.reserve(number_of_states);
+    for (uint32_t pattern = 0; pattern < flat_patterns.size(); ++pattern)
+    {
+        auto &flat = flat_patterns[pattern];
+        for (state_t state = 0; state < flat.GetNumberOfStates(); ++state)
+        {
+            auto symbols = flat.GetSymbols(state);
+            auto targets = flat.GetTargets(state);
+
+            for (size_t edge = 0; edge < targets.size(); ++edge)
+            {
+                symbols_.push_back(to_symbol(flat, symbols[edge]));
+                targets_.push_back(first_states[pattern] + targets[edge]);
+            }
+
+            offsets_.push_back(static_cast<uint32_t>(targets_.size()));
+
+            final_.push_back(flat.IsStateFinal(state));
+            if (flat.IsStateFinal(state))
+                accept_ids_.push_back(pattern);
+
+            accept_offsets_.push_back(static_cast<uint32_t>(accept_ids_.size()));
+            original_states_.push_back(flat.GetOriginalState(state));
+        }
+    }
+}
+
+Automaton FlatAutomaton::ToAutomaton(std::pmr::memory_resource *resource) const
+{
+    Automaton result(std::set<Automaton::alpha_t>(alphabet_.begin(), alphabet_.end()), GetNumberOfStates(), resource);
+    result.SetStartState(start_state_);
+
+    for (state_t state = 0; state < GetNumberOfStates(); ++state)
+    {
+        result.SetFinal(state, IsStateFinal(state));
+
+        auto symbols = GetSymbols(state);
+        auto targets = GetTargets(state);
+        for (size_t edge = 0; edge < targets.size(); ++edge)
+        {
+            auto alpha = symbols[edge] == GetEpsilonSymbol() ? Automaton::Epsilon : alphabet_[symbols[edge]];
+            result.AddEdge(state, targets[edge], alpha);
+        }
+    }
+
+    return result;
+}
+
+size_t FlatAutomaton::GetNumberOfStates() const { return final_.size(); }
+
+size_t FlatAutomaton::GetNumberOfTransitions() const { return targets_.size(); }
+
+size_t FlatAutomaton::GetAlphabetSize() const { return alphabet_.size(); }
+
+FlatAutomaton::symbol_t FlatAutomaton::GetEpsilonSymbol() const { return static_cast<symbol_t>(alphabet_.size()); }
+
+FlatAutomaton::symbol_t FlatAutomaton::GetSymbol(Automaton::alpha_t alpha) const
+{
+    auto position = std::lower_bound(alphabet_.begin(), alphabet_.end(), alpha);
+    if (position == alphabet_.end() || *position != alpha)
+        return NoSymbol;
+
+    return static_cast<symbol_t>(position - alphabet_.begin());
+}
+
+const std::vector<Automaton::alpha_t>& FlatAutomaton::GetAlphabet() const { return alphabet_; }
+
+std::span<const FlatAutomaton::symbol_t> FlatAutomaton::GetSymbols(state_t state) const
+{
+    return {symbols_.data() + offsets_[state], offsets_[state + 1] - offsets_[state]};
+}
+
+std::span<const FlatAutomaton::state_t> FlatAutomaton::GetTargets(state_t state) const
+{
+    return {targets_.data() + offsets_[state], offsets_[state + 1] - offsets_[state]};
+}
+
+std::span<const FlatAutomaton::state_t> FlatAutomaton::GetTargets(state_t state, symbol_t symbol) const
+{
+    auto symbols = GetSymbols(state);
+    auto range = std::equal_range(symbols.begin(), symbols.end(), symbol);
+
+    return GetTargets(state).subspan(static_cast<size_t>(range.first - symbols.begin()),
+                                     static_cast<size_t>(range.second - range.first));
+}
+
+FlatAutomaton::state_t FlatAutomaton::GetStartState() const { return start_state_; }
+
+bool FlatAutomaton::IsStateFinal(state_t state) const { return final_[state]; }
+
+bool FlatAutomaton::HasAcceptIds() const { return !accept_offsets_.empty(); }
+
+std::span<const uint32_t> FlatAutomaton::GetAcceptIds(state_t state) const
+{
+    if (!HasAcceptIds())
+        return {};
+
+    return {accept_ids_.data() + accept_offsets_[state], accept_offsets_[state + 1] - accept_offsets_[state]};
+}
+
+void FlatAutomaton::CollectAcceptIds(std::span<const size_t> states, std::vector<size_t> &ids) const
+{
+    ids.clear();
+    for (auto state : states)
+    {
+        auto state_ids = GetAcceptIds(static_cast<state_t>(state));
+        ids.insert(ids.end(), state_ids.begin(), state_ids.end());
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+size_t FlatAutomaton::GetOriginalState(state_t state) const { return original_states_[state]; }
+
+// Every state splits the classes of its symbols by their targets. Symbols
+// without edges from the state keep their class, so a state costs only its
+// edges.
+size_t FlatAutomaton::GetSymbolClasses(std::vector<uint32_t> &classes) const
+{
+    struct Split
+    {
+        uint32_t label;
+        uint64_t hash;
+        symbol_t symbol;
+        uint32_t first_edge;
+
+        bool operator<(const Split &other) const
+        {
+            return std::tie(label, hash, symbol) < std::tie(other.label, other.hash, other.symbol);
+        }
+    };
+
+    classes.assign(GetAlphabetSize(), 0);
+    size_t number_of_labels = 1;
+
+    std::vector<Split> splits;
+    std::vector<uint32_t> new_labels;
+
+    for (state_t state = 0; state < GetNumberOfStates(); ++state)
+    {
+        splits.clear();
+        for (uint32_t edge = offsets_[state], end = offsets_[state + 1]; edge < end;)
+        {
+            symbol_t symbol = symbols_[edge];
+            uint32_t first_edge = edge;
+            while (edge < end && symbols_[edge] == symbol)
+                ++edge;
+
+            if (symbol >= GetAlphabetSize())
+                continue;
+
+            auto targets = std::span<const state_t>(targets_.data() + first_edge, edge - first_edge);
+            splits.push_back({classes[symbol], SubsetTable::HashSequence(targets), symbol, first_edge});
+        }
+
+        std::sort(splits.begin(), splits.end());
+
+        new_labels.resize(splits.size());
+        for (size_t index = 0; index < splits.size(); ++index)
+        {
+            auto &split = splits[index];
+            auto &previous = splits[index > 0 ? index - 1 : 0];
+
+            bool same_class = index > 0 && previous.label == split.label && previous.hash == split.hash &&
+                              std::ranges::equal(GetTargets(state, previous.symbol), GetTargets(state, split.symbol));
+
+            new_labels[index] = same_class ? new_labels[index - 1] : static_cast<uint32_t>(number_of_labels++);
+        }
+
+        for (size_t index = 0; index < splits.size(); ++index)
+            classes[splits[index].symbol] = new_labels[index];
+    }
+
+    return RenumberLabels(classes, number_of_labels);
+}
+
+DenseDFA::DenseDFA(const std::vector<Automaton::alpha_t> &alphabet, size_t number_of_states):
+    alphabet_(alphabet),
+    table_(number_of_states * alphabet.size(), NoState),
+    final_(number_of_states, false),
+    start_state_(0),
+    accept_sets_(),
+    accept_id_sets_()
+{}
+
+DenseDFA::DenseDFA(const Automaton &automaton):
+    alphabet_(automaton.GetAlphabet().begin(), automaton.GetAlphabet().end()),
+    table_(),
+    final_(),
+    start_state_(0),
+    accept_sets_(),
+    accept_id_sets_()
+{
+    FlatAutomaton flat(automaton);
+
+    table_.assign(flat.GetNumberOfStates() * alphabet_.size(), NoState);
+    final_.resize(flat.GetNumberOfStates(), false);
+    start_state_ = flat.GetStartState();
+
+    bool is_deterministic = true;
+    for (state_t state = 0; state < flat.GetNumberOfStates(); ++state)
+    {
+        final_[state] = flat.IsStateFinal(state);
+
+        auto symbols = flat.GetSymbols(state);
+        auto targets = flat.GetTargets(state);
+        for (size_t edge = 0; edge < targets.size(); ++edge)
+        {
+            if (symbols[edge] == flat.GetEpsilonSymbol() ||
+                (edge > 0 && symbols[edge] == symbols[edge - 1]))
+            {
+                is_deterministic = false;
+                continue;
+            }
+
+            SetTransition(state, symbols[edge], targets[edge]);
+        }
+    }
+
+    if (!is_deterministic)
+        std::cerr << "Automaton is not deterministic. Only the first transition by every letter was kept.\n";
+}
+
+Automaton DenseDFA::ToAutomaton(std::pmr::memory_resource *resource) const
+{
+    Automaton result(std::set<Automaton::alpha_t>(alphabet_.begin(), alphabet_.end()), GetNumberOfStates(), resource);
+    result.SetStartState(start_state_);
+
+    for (state_t state = 0; state < GetNumberOfStates(); ++state)
+    {
+        result.SetFinal(state, IsStateFinal(state));
+
+        for (size_t symbol = 0; symbol < alphabet_.size(); ++symbol)
+        {
+            state_t target = GetTransition(state, symbol);
+            if (target != NoState)
+                result.AddEdge(state, target, alphabet_[symbol]);
+        }
+    }
+
+    return result;
+}
+
+DenseDFA::state_t DenseDFA::AddState()
+{
+    table_.resize(table_.size() + alphabet_.size(), NoState);
+    final_.push_back(false);
+    if (HasAcceptIds())
+        accept_sets_.push_back(0);
+
+    return static_cast<state_t>(final_.size() - 1);
+}
+
+size_t DenseDFA::GetNumberOfStates() const { return final_.size(); }
+
+size_t DenseDFA::GetAlphabetSize() const { return alphabet_.size(); }
+
+const std::vector<Automaton::alpha_t>& DenseDFA::GetAlphabet() const { return alphabet_; }
+
+void DenseDFA::SetTransition(state_t from, size_t symbol, state_t to) { table_[from * alphabet_.size() + symbol] = to; }
+
+std::span<const DenseDFA::state_t> DenseDFA::GetRow(state_t state) const
+{
+    return {table_.data() + state * alphabet_.size(), alphabet_.size()};
+}
+
+bool DenseDFA::IsComplete() const { return std::find(table_.begin(), table_.end(), NoState) == table_.end(); }
+
+void DenseDFA::SetStartState(state_t start_state) { start_state_ = start_state; }
+
+DenseDFA::state_t DenseDFA::GetStartState() const { return start_state_; }
+
+void DenseDFA::SetFinal(state_t state, bool is_final) { final_[state] = is_final; }
+
+bool DenseDFA::IsStateFinal(state_t state) const { return final_[state]; }
+
+void DenseDFA::SetAcceptIds(state_t state, std::span<const size_t> ids)
+{
+    if (!HasAcceptIds())
+    {
+        accept_id_sets_.Insert(std::span<const size_t>(), false);
+        accept_sets_.assign(GetNumberOfStates(), 0);
+    }
+
+    accept_sets_[state] = static_cast<uint32_t>(accept_id_sets_.Insert(ids, !ids.empty()));
+}
+
+bool DenseDFA::HasAcceptIds() const { return accept_id_sets_.Size() != 0; }
+
+std::span<const size_t> DenseDFA::GetAcceptIds(state_t state) const
+{
+    if (!HasAcceptIds())
+        return {};
+
+    return accept_id_sets_.GetSubset(accept_sets_[state]);
+}
+
+// Symbols with equal hashes of their columns are merged with the first of
+// them, and the rare ones whose columns differ after all get their own classes.
+size_t DenseDFA::GetSymbolClasses(std::vector<uint32_t> &classes) const
+{
+    size_t alphabet_size = GetAlphabetSize();
+
+    std::vector<uint64_t> hashes(alphabet_size, 0);
+    for (state_t state = 0; state < GetNumberOfStates(); ++state)
+    {
+        auto row = GetRow(state);
+        for (size_t symbol = 0; symbol < alphabet_size; ++symbol)
+            hashes[symbol] = SubsetTable::HashElement(hashes[symbol] ^ row[symbol]);
+    }
+
+    std::unordered_map<uint64_t, uint32_t> first_symbols;
+    classes.resize(alphabet_size);
+    for (size_t symbol = 0; symbol < alphabet_size; ++symbol)
+        classes[symbol] = first_symbols.try_emplace(hashes[symbol], static_cast<uint32_t>(symbol)).first->second;
+
+    for (state_t state = 0; state < GetNumberOfStates(); ++state)
+    {
+        auto row = GetRow(state);
+        for (size_t symbol = 0; symbol < alphabet_size; ++symbol)
+        {
+            if (row[symbol] != row[classes[symbol]])
+                classes[symbol] = static_cast<uint32_t>(symbol);
+        }
+    }
+
+    return RenumberLabels(classes, alphabet_size);
+}
+
+size_t DenseDFA::GetAcceptClasses(std::vector<uint32_t> &classes) const
+{
+    // Label 0 is for non-final states, final states get 1 + their accept set.
+    std::vector<uint32_t> label_classes(accept_id_sets_.Size() + 2, NoState);
+    size_t number_of_classes = 0;
+
+    classes.resize(GetNumberOfStates());
+    for (state_t state = 0; state < GetNumberOfStates(); ++state)
+    {
+        size_t label = IsStateFinal(state) ? 1 + (HasAcceptIds() ? accept_sets_[state] : 0) : 0;
+        if (label_classes[label] == NoState)
+            label_classes[label] = static_cast<uint32_t>(number_of_classes++);
+
+        classes[state] = label_classes[label];
+    }
+
+    return number_of_classes;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "automaton.hpp"
+#include "subset_table.hpp"
+
+// Compressed sparse row copy of an automaton: states are renumbered densely,
+// symbols are indices into the sorted alphabet and the edges of every state
+// are packed into contiguous (symbol, target) arrays sorted by symbol.
+// Epsilon edges use the symbol right after the alphabet.
+class FlatAutomaton
+{
+    public:
+        using state_t = uint32_t;
+        using symbol_t = uint32_t;
+
+        static const symbol_t NoSymbol;
+
+        explicit FlatAutomaton(const Automaton &automaton);
+
+        // Union of the patterns with a shared start state 0. Every final state
+        // carries the indices of the patterns it accepts. DFAFromNFA doesn't
+        // follow epsilon edges, so MultiPatternDFA removes them first.
+        explicit FlatAutomaton(const std::vector<Automaton> &patterns);
+
+        Automaton ToAutomaton(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+        size_t GetNumberOfStates() const;
+        size_t GetNumberOfTransitions() const;
+
+        size_t GetAlphabetSize() const;
+        symbol_t GetEpsilonSymbol() const;
+        symbol_t GetSymbol(Automaton::alpha_t alpha) const;
+        const std::vector<Automaton::alpha_t>& GetAlphabet() const;
+
+        std::span<const symbol_t> GetSymbols(state_t state) const;
+        std::span<const state_t> GetTargets(state_t state) const;
+        std::span<const state_t> GetTargets(state_t state, symbol_t symbol) const;
+
+        state_t GetStartState() const;
+        bool IsStateFinal(state_t state) const;
+
+        bool HasAcceptIds() const;
+        std::span<const uint32_t> GetAcceptIds(state_t state) const;
+        void CollectAcceptIds(std::span<const size_t> states, std::vector<size_t> &ids) const;
+
+        size_t GetOriginalState(state_t state) const;
+
+        // Numbers symbols with the same targets in every state equally, in the
+        // order of their first symbol. Returns the number of classes.
+        size_t GetSymbolClasses(std::vector<uint32_t> &classes) const;
+
+    private:
+        std::vector<Automaton::alpha_t> alphabet_;
+
+        std::vector<uint32_t> offsets_;
+        std::vector<symbol_t> symbols_;
+        std::vector<state_t> targets_;
+
+        std::vector<uint8_t> final_;
+        state_t start_state_ = 0;
+
+        std::vector<uint32_t> accept_offsets_;
+        std::vector<uint32_t> accept_ids_;
+
+        std::vector<size_t> original_states_;
+};
+
+// Row-major states x alphabet transition table of a DFA. Missing transitions
+// hold NoState until the automaton is made complete. A DFA built from several
+// patterns also keeps the set of accepted pattern indices of every state.
+class DenseDFA
+{
+    public:
+        using state_t = uint32_t;
+
+        static const state_t NoState;
+
+        DenseDFA(const std::vector<Automaton::alpha_t> &alphabet, size_t number_of_states = 1);
+        explicit DenseDFA(const Automaton &automaton);
+
+        Automaton ToAutomaton(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+        state_t AddState();
+        size_t GetNumberOfStates() const;
+
+        size_t GetAlphabetSize() const;
+        const std::vector<Automaton::alpha_t>& GetAlphabet() const;
+
+        void SetTransition(state_t from, size_t symbol, state_t to);
+        state_t GetTransition(state_t from, size_t symbol) const { return table_[from * alphabet_.size() + symbol]; }
+        std::span<const state_t> GetRow(state_t state) const;
+
+        bool IsComplete() const;
+
+        void SetStartState(state_t start_state);
+        state_t GetStartState() const;
+
+        void SetFinal(state_t state, bool is_final = true);
+        bool IsStateFinal(state_t state) const;
+
+        // Accept IDs of non-final states are ignored.
+        void SetAcceptIds(state_t state, std::span<const size_t> ids);
+        bool HasAcceptIds() const;
+        std::span<const size_t> GetAcceptIds(state_t state) const;
+
+        // Numbers states with equal finality and accept IDs equally, in the
+        // order of their first state. Returns the number of classes.
+        size_t GetAcceptClasses(std::vector<uint32_t> &classes) const;
+
+        // Numbers symbols with the same column of the table equally, in the
+        // order of their first symbol. Returns the number of classes.
+        size_t GetSymbolClasses(std::vector<uint32_t> &classes) const;
+
+    private:
+        std::vector<Automaton::alpha_t> alphabet_;
+        std::vector<state_t> table_;
+
+        std::vector<uint8_t> final_;
+        state_t start_state_ = 0;
+
+        // Index of the accept set of every state in accept_id_sets_, where the
+        // empty set is 0. Empty if no accept IDs were set.
+        std::vector<uint32_t> accept_sets_;
+        SubsetTable accept_id_sets_;
+};
@@ -0,0 +1,745 @@
+#include <algorithm>
+#include <iostream>
+
+#include "automaton_algorithms.hpp"
+#include "automaton_statistics.hpp"
+#include "subset_table.hpp"
+
+namespace
+{
+    // Gives equal rows equal class numbers, numbering classes in the order of
+    // their first row. Returns the number of classes.
+    size_t GroupEqualRows(const std::vector<uint32_t> &rows, size_t row_size, std::vector<uint32_t> &classes)
+    {
+        size_t number_of_rows = row_size == 0 ? 0 : rows.size() / row_size;
+
+        size_t capacity = 16;
+        while (capacity < 2 * number_of_rows)
+            capacity *= 2;
+
+        std::vector<uint32_t> slots(capacity, DenseDFA::NoState);
+        size_t mask = capacity - 1;
+
+        classes.resize(number_of_rows);
+        size_t number_of_classes = 0;
+
+        for (size_t row = 0; row < number_of_rows; ++row)
+        {
+            std::span<const uint32_t> values(rows.data() + row * row_size, row_size);
+
+            size_t slot = SubsetTable::HashSequence(values) & mask;
+            while (slots[slot] != DenseDFA::NoState)
+            {
+                std::span<const uint32_t> other(rows.data() + slots[slot] * row_size, row_size);
+                if (std::equal(values.begin(), values.end(), other.begin()))
+                    break;
+
+                slot = (slot + 1) & mask;
+            }
+
+            if (slots[slot] == DenseDFA::NoState)
+            {
+                slots[slot] = static_cast<uint32_t>(row);
+                classes[row] = static_cast<uint32_t>(number_of_classes++);
+            }
+            else
+            {
+                classes[row] = classes[slots[slot]];
+            }
+        }
+
+        return number_of_classes;
+    }
+
+    size_t MooreClasses(const DenseDFA &automaton, std::vector<uint32_t> &classes)
+    {
+        size_t number_of_states = automaton.GetNumberOfStates();
+        size_t alphabet_size = automaton.GetAlphabetSize();
+        size_t row_size = alphabet_size + 1;
+
+        std::vector<uint32_t> factor_set(number_of_states * row_size);
+        size_t old_number_of_classes = 0;
+        size_t cur_classes = automaton.GetAcceptClasses(classes);
+
+        while (cur_classes != old_number_of_classes)
+        {
+            old_number_of_classes = cur_classes;
+
+            for (DenseDFA::state_t state = 0; state < number_of_states; ++state)
+            {
+                uint32_t *row = factor_set.data() + state * row_size;
+                row[0] = classes[state];
+
+                auto transitions = automaton.GetRow(state);
+                for (size_t symbol = 0; symbol < alphabet_size; ++symbol)
+                    row[symbol + 1] = classes[transitions[symbol]];
+            }
+
+            cur_classes = GroupEqualRows(factor_set, row_size, classes);
+
+            AUTOMATON_COUNT(RefinementRounds, 1);
+            AUTOMATON_CLASSES(cur_classes);
+        }
+
+        return cur_classes;
+    }
+
+    // Refinable partition of the states: every block is a contiguous range of
+    // elements_, and its marked states are kept at the front of the range.
+    class StatePartition
+    {
+        public:
+            explicit StatePartition(size_t number_of_states):
+                elements_(number_of_states),
+                locations_(number_of_states),
+                blocks_(number_of_states, 0),
+                first_(),
+                marked_end_(),
+                end_()
+            {
+                for (uint32_t state = 0; state < number_of_states; ++state)
+                {
+                    elements_[state] = state;
+                    locations_[state] = state;
+                }
+
+                if (number_of_states != 0)
+                    AddBlock(0, static_cast<uint32_t>(number_of_states));
+            }
+
+            size_t GetNumberOfBlocks() const { return first_.size(); }
+            uint32_t GetBlock(uint32_t state) const { return blocks_[state]; }
+            size_t GetBlockSize(uint32_t block) const { return end_[block] - first_[block]; }
+
+            std::span<const uint32_t> GetStates(uint32_t block) const
+            {
+                return {elements_.data() + first_[block], GetBlockSize(block)};
+            }
+
+            // Returns true if this is the first marked state of its block.
+            bool Mark(uint32_t state)
+            {
+                uint32_t block = blocks_[state];
+                uint32_t location = locations_[state];
+                if (location < marked_end_[block])
+                    return false;
+
+                uint32_t swapped_location = marked_end_[block]++;
+                std::swap(elements_[location], elements_[swapped_location]);
+                locations_[elements_[location]] = location;
+                locations_[elements_[swapped_location]] = swapped_location;
+
+                return swapped_location == first_[block];
+            }
+
+            // Moves the marked states of the block to a new block. Returns the
+            // new block, or NoState if none or all of its states were marked.
+            uint32_t SplitMarked(uint32_t block)
+            {
+                uint32_t marked_end = marked_end_[block];
+                marked_end_[block] = first_[block];
+
+                if (marked_end == first_[block] || marked_end == end_[block])
+                    return DenseDFA::NoState;
+
+                uint32_t new_block = AddBlock(first_[block], marked_end);
+                first_[block] = marked_end;
+                marked_end_[block] = marked_end;
+
+                for (uint32_t location = first_[new_block]; location < end_[new_block]; ++location)
+                    blocks_[elements_[location]] = new_block;
+
+                return new_block;
+            }
+
+        private:
+            std::vector<uint32_t> elements_;
+            std::vector<uint32_t> locations_;
+            std::vector<uint32_t> blocks_;
+
+            std::vector<uint32_t> first_;
+            std::vector<uint32_t> marked_end_;
+            std::vector<uint32_t> end_;
+
+            uint32_t AddBlock(uint32_t first, uint32_t end)
+            {
+                first_.push_back(first);
+                marked_end_.push_back(first);
+                end_.push_back(end);
+
+                return static_cast<uint32_t>(first_.size() - 1);
+            }
+    };
+
+    size_t HopcroftClasses(const DenseDFA &automaton, std::vector<uint32_t> &classes)
+    {
+        uint32_t number_of_states = static_cast<uint32_t>(automaton.GetNumberOfStates());
+        size_t alphabet_size = automaton.GetAlphabetSize();
+
+        // Predecessors of every (state, symbol) pair in CSR form.
+        std::vector<uint32_t> inverse_offsets(number_of_states * alphabet_size + 1, 0);
+        std::vector<uint32_t> inverse_sources(number_of_states * alphabet_size);
+
+        for (uint32_t state = 0; state < number_of_states; ++state)
+        {
+            auto transitions = automaton.GetRow(state);
+            for (size_t symbol = 0; symbol < alphabet_size; ++symbol)
+                ++inverse_offsets[transitions[symbol] * alphabet_size + symbol + 1];
+        }
+
+        for (size_t index = 1; index < inverse_offsets.size(); ++index)
+            inverse_offsets[index] += inverse_offsets[index - 1];
+
+        std::vector<uint32_t> fill_positions(inverse_offsets.begin(), inverse_offsets.end() - 1);
+        for (uint32_t state = 0; state < number_of_states; ++state)
+        {
+            auto transitions = automaton.GetRow(state);
+            for (size_t symbol = 0; symbol < alphabet_size; ++symbol)
+                inverse_sources[fill_positions[transitions[symbol] * alphabet_size + symbol]++] = state;
+        }
+
+        StatePartition partition(number_of_states);
+        std::vector<uint32_t> worklist;
+        std::vector<bool> in_worklist;
+
+        auto add_to_worklist = [&worklist, &in_worklist](uint32_t block)
+        {
+            if (in_worklist.size() <= block)
+                in_worklist.resize(block + 1, false);
+
+            if (!in_worklist[block])
+            {
+                in_worklist[block] = true;
+                worklist.push_back(block);
+            }
+        };
+
+        // The initial blocks are the accept classes. All of them but the
+        // largest one are splitters.
+        std::vector<uint32_t> accept_classes;
+        size_t number_of_accept_classes = automaton.GetAcceptClasses(accept_classes);
+
+        std::vector<uint32_t> class_offsets(number_of_accept_classes + 1, 0);
+        for (auto accept_class : accept_classes)
+            ++class_offsets[accept_class + 1];
+
+        for (size_t accept_class = 1; accept_class < class_offsets.size(); ++accept_class)
+            class_offsets[accept_class] += class_offsets[accept_class - 1];
+
+        std::vector<uint32_t> states_by_class(number_of_states);
+        std::vector<uint32_t> class_positions(class_offsets.begin(), class_offsets.end() - 1);
+        for (uint32_t state = 0; state < number_of_states; ++state)
+            states_by_class[class_positions[accept_classes[state]]++] = state;
+
+        for (size_t accept_class = 1; accept_class < number_of_accept_classes; ++accept_class)
+        {
+            for (uint32_t index = class_offsets[accept_class]; index < class_offsets[accept_class + 1]; ++index)
+                partition.Mark(states_by_class[index]);
+
+            partition.SplitMarked(0);
+        }
+
+        uint32_t largest_block = 0;
+        for (uint32_t block = 0; block < partition.GetNumberOfBlocks(); ++block)
+        {
+            if (partition.GetBlockSize(block) > partition.GetBlockSize(largest_block))
+                largest_block = block;
+        }
+
+        for (uint32_t block = 0; block < partition.GetNumberOfBlocks(); ++block)
+        {
+            if (block != largest_block || partition.GetNumberOfBlocks() == 1)
+                add_to_worklist(block);
+        }
+
+        std::vector<uint32_t> splitter;
+        std::vector<uint32_t> touched_blocks;
+
+        while (!worklist.empty())
+        {
+            uint32_t splitter_block = worklist.back();
+            worklist.pop_back();
+            in_worklist[splitter_block] = false;
+            AUTOMATON_COUNT(RefinementRounds, 1);
+
+            auto splitter_states = partition.GetStates(splitter_block);
+            splitter.assign(splitter_states.begin(), splitter_states.end());
+
+            for (size_t symbol = 0; symbol < alphabet_size; ++symbol)
+            {
+                touched_blocks.clear();
+                for (auto state : splitter)
+                {
+                    size_t index = state * alphabet_size + symbol;
+                    for (uint32_t edge = inverse_offsets[index]; edge < inverse_offsets[index + 1]; ++edge)
+                    {
+                        uint32_t source = inverse_sources[edge];
+                        if (partition.Mark(source))
+                            touched_blocks.push_back(partition.GetBlock(source));
+                    }
+                }
+
+                for (auto block : touched_blocks)
+                {
+                    uint32_t new_block = partition.SplitMarked(block);
+                    if (new_block == DenseDFA::NoState)
+                        continue;
+
+                    if (block < in_worklist.size() && in_worklist[block])
+                        add_to_worklist(new_block);
+                    else if (partition.GetBlockSize(new_block) <= partition.GetBlockSize(block))
+                        add_to_worklist(new_block);
+                    else
+                        add_to_worklist(block);
+                }
+            }
+        }
+
+        // Number classes by their first state, the same way MooreClasses does.
+        std::vector<uint32_t> block_classes(partition.GetNumberOfBlocks(), DenseDFA::NoState);
+        size_t number_of_classes = 0;
+
+        classes.resize(number_of_states);
+        for (uint32_t state = 0; state < number_of_states; ++state)
+        {
+            uint32_t &block_class = block_classes[partition.GetBlock(state)];
+            if (block_class == DenseDFA::NoState)
+                block_class = static_cast<uint32_t>(number_of_classes++);
+
+            classes[state] = block_class;
+        }
+
+        AUTOMATON_CLASSES(number_of_classes);
+        return number_of_classes;
+    }
+
+    std::vector<std::vector<uint32_t>> GetSymbolsOfClasses(const std::vector<uint32_t> &classes, size_t number_of_classes)
+    {
+        std::vector<std::vector<uint32_t>> symbols_of_classes(number_of_classes);
+        for (size_t symbol = 0; symbol < classes.size(); ++symbol)
+            symbols_of_classes[classes[symbol]].push_back(static_cast<uint32_t>(symbol));
+
+        return symbols_of_classes;
+    }
+
+    // The DFA over the first symbols of the classes.
+    DenseDFA KeepFirstSymbols(const DenseDFA &automaton, const std::vector<std::vector<uint32_t>> &symbols_of_classes)
+    {
+        std::vector<Automaton::alpha_t> alphabet;
+        for (auto &class_symbols : symbols_of_classes)
+            alphabet.push_back(automaton.GetAlphabet()[class_symbols.front()]);
+
+        DenseDFA result(alphabet, automaton.GetNumberOfStates());
+        result.SetStartState(automaton.GetStartState());
+
+        for (DenseDFA::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+        {
+            result.SetFinal(state, automaton.IsStateFinal(state));
+            if (automaton.HasAcceptIds())
+                result.SetAcceptIds(state, automaton.GetAcceptIds(state));
+
+            for (size_t symbol_class = 0; symbol_class < symbols_of_classes.size(); ++symbol_class)
+                result.SetTransition(state, symbol_class, automaton.GetTransition(state, symbols_of_classes[symbol_class].front()));
+        }
+
+        return result;
+    }
+
+    // Gives every symbol of a class the transitions of the class.
+    DenseDFA SpreadSymbols(const DenseDFA &automaton, const std::vector<Automaton::alpha_t> &alphabet,
+                           const std::vector<std::vector<uint32_t>> &symbols_of_classes)
+    {
+        DenseDFA result(alphabet, automaton.GetNumberOfStates());
+        result.SetStartState(automaton.GetStartState());
+
+        for (DenseDFA::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+        {
+            result.SetFinal(state, automaton.IsStateFinal(state));
+            if (automaton.HasAcceptIds())
+                result.SetAcceptIds(state, automaton.GetAcceptIds(state));
+
+            for (size_t symbol_class = 0; symbol_class < symbols_of_classes.size(); ++symbol_class)
+            {
+                for (auto symbol : symbols_of_classes[symbol_class])
+                    result.SetTransition(state, symbol, automaton.GetTransition(state, symbol_class));
+            }
+        }
+
+        return result;
+    }
+};
+
+void AutomatonTransformer::MakeDFAComplete(DenseDFA &automaton)
+{
+    AUTOMATON_STAGE("MakeDFAComplete");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    if (automaton.IsComplete())
+    {
+        AUTOMATON_STAGE_OUTPUT(automaton);
+        return;
+    }
+
+    auto garbage_state = automaton.AddState();
+    for (DenseDFA::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+    {
+        for (size_t symbol = 0; symbol < automaton.GetAlphabetSize(); ++symbol)
+        {
+            if (automaton.GetTransition(state, symbol) == DenseDFA::NoState)
+                automaton.SetTransition(state, symbol, garbage_state);
+        }
+    }
+
+    AUTOMATON_STAGE_OUTPUT(automaton);
+}
+
+DenseDFA AutomatonTransformer::DFAFromNFA(const FlatAutomaton &automaton)
+{
+    AUTOMATON_STAGE("DFAFromNFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    DenseDFA DFA(automaton.GetAlphabet(), 0);
+
+    size_t start_state = automaton.GetStartState();
+    SubsetTable subsets;
+    subsets.Insert(std::vector<size_t>{start_state}, automaton.IsStateFinal(automaton.GetStartState()));
+    DFA.SetFinal(DFA.AddState(), subsets.IsFinal(0));
+
+    std::vector<size_t> accept_ids;
+    if (automaton.HasAcceptIds())
+    {
+        automaton.CollectAcceptIds(subsets.GetSubset(0), accept_ids);
+        DFA.SetAcceptIds(0, accept_ids);
+    }
+
+    // States that can't reach a final state are left out of the subsets, so
+    // subsets of only such states become missing transitions.
+    std::vector<uint8_t> useful;
+    GetUsefulStates(automaton, useful);
+
+    std::vector<size_t> visit_marks(automaton.GetNumberOfStates(), 0);
+    size_t current_mark = 0;
+
+    // Subsets are computed once per class of equivalent symbols; the first
+    // symbol of a class comes first, so states are numbered as without classes.
+    std::vector<uint32_t> symbol_classes;
+    auto symbols_of_classes = GetSymbolsOfClasses(symbol_classes, automaton.GetSymbolClasses(symbol_classes));
+
+    std::vector<size_t> old_state;
+    std::vector<size_t> new_state;
+
+    for (size_t state = 0; state < subsets.Size(); ++state)
+    {
+        auto subset = subsets.GetSubset(state);
+        old_state.assign(subset.begin(), subset.end());
+
+        for (auto &class_symbols : symbols_of_classes)
+        {
+            FlatAutomaton::symbol_t symbol = class_symbols.front();
+            ++current_mark;
+            new_state.clear();
+            uint64_t hash = 0;
+
+            for (auto state_in_new_state : old_state)
+            {
+                for (auto neighbour : automaton.GetTargets(static_cast<FlatAutomaton::state_t>(state_in_new_state), symbol))
+                {
+                    if (visit_marks[neighbour] == current_mark || !useful[neighbour])
+                        continue;
+
+                    visit_marks[neighbour] = current_mark;
+                    new_state.push_back(neighbour);
+                    hash += SubsetTable::HashElement(neighbour);
+                }
+            }
+
+            if (new_state.empty())
+                continue;
+
+            std::sort(new_state.begin(), new_state.end());
+            hash = SubsetTable::FinalizeHash(hash, new_state.size());
+
+            size_t target = subsets.Find(new_state, hash);
+            if (target == SubsetTable::NotFound)
+            {
+                bool is_final = std::any_of(new_state.begin(), new_state.end(),
+                                            [&automaton](size_t neighbour)
+                                            {
+                                                return automaton.IsStateFinal(static_cast<FlatAutomaton::state_t>(neighbour));
+                                            });
+
+                target = subsets.Insert(new_state, hash, is_final);
+                DFA.SetFinal(DFA.AddState(), is_final);
+
+                if (automaton.HasAcceptIds())
+                {
+                    automaton.CollectAcceptIds(new_state, accept_ids);
+                    DFA.SetAcceptIds(static_cast<DenseDFA::state_t>(target), accept_ids);
+                }
+            }
+
+            for (auto class_symbol : class_symbols)
+                DFA.SetTransition(static_cast<DenseDFA::state_t>(state), class_symbol, static_cast<DenseDFA::state_t>(target));
+        }
+    }
+
+    AUTOMATON_STAGE_OUTPUT(DFA);
+    return DFA;
+}
+
+DenseDFA AutomatonTransformer::CDFAFromDFA(const DenseDFA &automaton)
+{
+    AUTOMATON_STAGE("CDFAFromDFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    DenseDFA result = automaton;
+    MakeDFAComplete(result);
+
+    AUTOMATON_STAGE_OUTPUT(result);
+    return result;
+}
+
+DenseDFA AutomatonTransformer::MCDFAFromCDFA(const DenseDFA &automaton, MinimizationAlgorithm algorithm)
+{
+    AUTOMATON_STAGE("MCDFAFromCDFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    if (!automaton.IsComplete())
+    {
+        std::cerr << "Automaton is not complete. It will be completed before minimization.\n";
+        auto minimal = MCDFAFromCDFA(CDFAFromDFA(automaton), algorithm);
+        AUTOMATON_STAGE_OUTPUT(minimal);
+        return minimal;
+    }
+
+    // Unreachable states would stay in the quotient as classes of their own.
+    std::vector<uint8_t> reachable;
+    if (GetReachableStates(automaton, reachable) < automaton.GetNumberOfStates())
+    {
+        auto minimal = MCDFAFromCDFA(RestrictDFA(automaton, reachable), algorithm);
+        AUTOMATON_STAGE_OUTPUT(minimal);
+        return minimal;
+    }
+
+    // Equivalent symbols split the same blocks, so only one of each class is kept.
+    std::vector<uint32_t> symbol_classes;
+    size_t number_of_symbol_classes = automaton.GetSymbolClasses(symbol_classes);
+    if (number_of_symbol_classes < automaton.GetAlphabetSize())
+    {
+        auto symbols_of_classes = GetSymbolsOfClasses(symbol_classes, number_of_symbol_classes);
+        auto minimal = SpreadSymbols(MCDFAFromCDFA(KeepFirstSymbols(automaton, symbols_of_classes), algorithm),
+                                     automaton.GetAlphabet(), symbols_of_classes);
+
+        AUTOMATON_STAGE_OUTPUT(minimal);
+        return minimal;
+    }
+
+    std::vector<uint32_t> classes;
+    size_t number_of_classes = 0;
+    DenseDFA minimal(automaton.GetAlphabet(), 0);
+
+    switch (algorithm)
+    {
+        case MinimizationAlgorithm::Moore:
+            number_of_classes = MooreClasses(automaton, classes);
+            minimal = QuotientOfDFA(automaton, classes, number_of_classes);
+            break;
+
+        case MinimizationAlgorithm::Hopcroft:
+            number_of_classes = HopcroftClasses(automaton, classes);
+            minimal = QuotientOfDFA(automaton, classes, number_of_classes);
+            break;
+
+        case MinimizationAlgorithm::ParallelMoore:
+            minimal = ParallelMCDFAFromCDFA(automaton);
+            break;
+
+        default:
+            std::cerr << "Unknown minimization algorithm.\n";
+            minimal = automaton;
+            break;
+    }
+
+    AUTOMATON_STAGE_OUTPUT(minimal);
+    return minimal;
+}
+
+DenseDFA AutomatonTransformer::MultiPatternDFA(const std::vector<Automaton> &patterns, MinimizationAlgorithm algorithm)
+{
+    // The subset construction doesn't follow epsilon edges.
+    std::vector<Automaton> epsilon_free(patterns);
+    for (auto &pattern : epsilon_free)
+        RemoveEpsTransitions(pattern);
+
+    return MCDFAFromCDFA(CDFAFromDFA(DFAFromNFA(FlatAutomaton(epsilon_free))), algorithm);
+}
+
+DenseDFA AutomatonTransformer::QuotientOfDFA(const DenseDFA &automaton, const std::vector<uint32_t> &classes,
+                                             size_t number_of_classes)
+{
+    DenseDFA quotient(automaton.GetAlphabet(), number_of_classes);
+    quotient.SetStartState(classes[automaton.GetStartState()]);
+
+    for (DenseDFA::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+    {
+        quotient.SetFinal(classes[state], automaton.IsStateFinal(state));
+        if (automaton.HasAcceptIds())
+            quotient.SetAcceptIds(classes[state], automaton.GetAcceptIds(state));
+
+        auto transitions = automaton.GetRow(state);
+        for (size_t symbol = 0; symbol < automaton.GetAlphabetSize(); ++symbol)
+        {
+            if (transitions[symbol] != DenseDFA::NoState)
+                quotient.SetTransition(classes[state], symbol, classes[transitions[symbol]]);
+        }
+    }
+
+    return quotient;
+}
+
+DenseDFA AutomatonTransformer::RestrictDFA(const DenseDFA &automaton, const std::vector<uint8_t> &keep)
+{
+    std::vector<DenseDFA::state_t> new_states(automaton.GetNumberOfStates(), DenseDFA::NoState);
+    DenseDFA::state_t number_of_states = 0;
+    for (DenseDFA::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+    {
+        if (keep[state])
+            new_states[state] = number_of_states++;
+    }
+
+    DenseDFA result(automaton.GetAlphabet(), number_of_states);
+    result.SetStartState(new_states[automaton.GetStartState()]);
+
+    for (DenseDFA::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+    {
+        if (!keep[state])
+            continue;
+
+        result.SetFinal(new_states[state], automaton.IsStateFinal(state));
+        if (automaton.HasAcceptIds())
+            result.SetAcceptIds(new_states[state], automaton.GetAcceptIds(state));
+
+        auto transitions = automaton.GetRow(state);
+        for (size_t symbol = 0; symbol < automaton.GetAlphabetSize(); ++symbol)
+        {
+            if (transitions[symbol] != DenseDFA::NoState)
+                result.SetTransition(new_states[state], symbol, new_states[transitions[symbol]]);
+        }
+    }
+
+    return result;
+}
+
+size_t AutomatonTransformer::GetReachableStates(const FlatAutomaton &automaton, std::vector<uint8_t> &reachable)
+{
+    reachable.assign(automaton.GetNumberOfStates(), false);
+    if (automaton.GetNumberOfStates() == 0)
+        return 0;
+
+    std::vector<FlatAutomaton::state_t> queue(1, automaton.GetStartState());
+    reachable[automaton.GetStartState()] = true;
+
+    for (size_t index = 0; index < queue.size(); ++index)
+    {
+        for (auto target : automaton.GetTargets(queue[index]))
+        {
+            if (reachable[target])
+                continue;
+
+            reachable[target] = true;
+            queue.push_back(target);
+        }
+    }
+
+    return queue.size();
+}
+
+size_t AutomatonTransformer::GetReachableStates(const DenseDFA &automaton, std::vector<uint8_t> &reachable)
+{
+    reachable.assign(automaton.GetNumberOfStates(), false);
+    if (automaton.GetNumberOfStates() == 0)
+        return 0;
+
+    std::vector<DenseDFA::state_t> queue(1, automaton.GetStartState());
+    reachable[automaton.GetStartState()] = true;
+
+    for (size_t index = 0; index < queue.size(); ++index)
+    {
+        for (auto target : automaton.GetRow(queue[index]))
+        {
+            if (target == DenseDFA::NoState || reachable[target])
+                continue;
+
+            reachable[target] = true;
+            queue.push_back(target);
+        }
+    }
+
+    return queue.size();
+}
+
+size_t AutomatonTransformer::GetUsefulStates(const FlatAutomaton &automaton, std::vector<uint8_t> &useful)
+{
+    if (GetReachableStates(automaton, useful) == 0)
+        return 0;
+
+    size_t number_of_states = automaton.GetNumberOfStates();
+
+    // Edges of the reachable states reversed, in the same CSR form.
+    std::vector<uint32_t> offsets(number_of_states + 1, 0);
+    for (FlatAutomaton::state_t state = 0; state < number_of_states; ++state)
+    {
+        if (!useful[state])
+            continue;
+
+        for (auto target : automaton.GetTargets(state))
+            ++offsets[target + 1];
+    }
+
+    for (size_t state = 0; state < number_of_states; ++state)
+        offsets[state + 1] += offsets[state];
+
+    std::vector<FlatAutomaton::state_t> sources(offsets.back());
+    std::vector<uint32_t> positions(offsets.begin(), offsets.end() - 1);
+    for (FlatAutomaton::state_t state = 0; state < number_of_states; ++state)
+    {
+        if (!useful[state])
+            continue;
+
+        for (auto target : automaton.GetTargets(state))
+            sources[positions[target]++] = state;
+    }
+
+    std::vector<uint8_t> co_reachable(number_of_states, false);
+    std::vector<FlatAutomaton::state_t> queue;
+    for (FlatAutomaton::state_t state = 0; state < number_of_states; ++state)
+    {
+        if (useful[state] && automaton.IsStateFinal(state))
+        {
+            co_reachable[state] = true;
+            queue.push_back(state);
+        }
+    }
+
+    for (size_t index = 0; index < queue.size(); ++index)
+    {
+        auto state = queue[index];
+        for (uint32_t edge = offsets[state]; edge < offsets[state + 1]; ++edge)
+        {
+            if (co_reachable[sources[edge]])
+                continue;
+
+            co_reachable[sources[edge]] = true;
+            queue.push_back(sources[edge]);
+        }
+    }
+
+    size_t number_of_useful_states = 0;
+    for (FlatAutomaton::state_t state = 0; state < number_of_states; ++state)
+    {
+        useful[state] = state == automaton.GetStartState() || (useful[state] && co_reachable[state]);
+        number_of_useful_states += useful[state];
+    }
+
+    return number_of_useful_states;
+}
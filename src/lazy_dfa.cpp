@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <limits>
+
+#include "lazy_dfa.hpp"
+
+namespace
+{
+    const uint32_t Unknown_state = std::numeric_limits<uint32_t>::max();
+    const uint32_t Dead_state = Unknown_state - 1;
+
+    // The cache is considered thrashing if it was flushed before it served
+    // this many input bytes per cached state.
+    const size_t Min_bytes_per_state = 10;
+};
+
+LazyDFA::LazyDFA(const Automaton &automaton, size_t memory_budget):
+    automaton_(automaton),
+    symbols_(),
+    memory_budget_(memory_budget),
+    subsets_(),
+    transitions_(),
+    number_of_flushes_(0),
+    number_of_fallbacks_(0),
+    bytes_since_flush_(0),
+    visit_marks_(automaton_.GetNumberOfStates(), 0),
+    current_mark_(0),
+    closure_stack_(),
+    new_state_(),
+    old_state_()
+{
+    symbols_.fill(FlatAutomaton::NoSymbol);
+    for (size_t byte = 0; byte < symbols_.size(); ++byte)
+        symbols_[byte] = automaton_.GetSymbol(static_cast<Automaton::alpha_t>(byte));
+}
+
+bool LazyDFA::Accepts(std::string_view input)
+{
+    size_t alphabet_size = automaton_.GetAlphabetSize();
+    state_t state = GetStartState();
+
+    size_t flush_position = 0;
+    size_t position = 0;
+    bool result = true;
+
+    for (; position < input.size(); ++position)
+    {
+        auto symbol = symbols_[static_cast<unsigned char>(input[position])];
+        if (symbol == FlatAutomaton::NoSymbol)
+        {
+            result = false;
+            break;
+        }
+
+        state_t next = transitions_[state * alphabet_size + symbol];
+        if (next == Unknown_state)
+        {
+            auto subset = subsets_.GetSubset(state);
+            old_state_.assign(subset.begin(), subset.end());
+            Move(old_state_, symbol, new_state_);
+
+            if (new_state_.empty())
+            {
+                next = Dead_state;
+                transitions_[state * alphabet_size + symbol] = next;
+            }
+            else
+            {
+                size_t cached_states = subsets_.Size();
+                size_t flushes = number_of_flushes_;
+                next = AddState(new_state_);
+
+                if (flushes == number_of_flushes_)
+                {
+                    transitions_[state * alphabet_size + symbol] = next;
+                }
+                else
+                {
+                    size_t scanned_bytes = bytes_since_flush_ + position - flush_position;
+                    bytes_since_flush_ = 0;
+                    flush_position = position;
+
+                    if (scanned_bytes < Min_bytes_per_state * cached_states)
+                    {
+                        ++number_of_fallbacks_;
+                        return SimulateNFA(new_state_, input.substr(position + 1));
+                    }
+                }
+            }
+        }
+
+        if (next == Dead_state)
+        {
+            result = false;
+            break;
+        }
+
+        state = next;
+    }
+
+    bytes_since_flush_ += position - flush_position;
+
+    return result && subsets_.IsFinal(state);
+}
+
+size_t LazyDFA::GetNumberOfCachedStates() const { return subsets_.Size(); }
+
+size_t LazyDFA::GetMemoryUsage() const { return subsets_.GetMemoryUsage() + transitions_.size() * sizeof(state_t); }
+
+size_t LazyDFA::GetNumberOfFlushes() const { return number_of_flushes_; }
+
+size_t LazyDFA::GetNumberOfFallbacks() const { return number_of_fallbacks_; }
+
+LazyDFA::state_t LazyDFA::AddState(std::vector<size_t> &subset)
+{
+    uint64_t hash = SubsetTable::Hash(subset);
+    size_t state = subsets_.Find(subset, hash);
+    if (state != SubsetTable::NotFound)
+        return static_cast<state_t>(state);
+
+    size_t state_cost = (subset.size() + 4) * sizeof(size_t) + automaton_.GetAlphabetSize() * sizeof(state_t);
+    if (subsets_.Size() != 0 && GetMemoryUsage() + state_cost > memory_budget_)
+        Flush();
+
+    bool is_final = std::any_of(subset.begin(), subset.end(),
+                                [this](size_t nfa_state)
+                                {
+                                    return automaton_.IsStateFinal(static_cast<FlatAutomaton::state_t>(nfa_state));
+                                });
+
+    state = subsets_.Insert(subset, hash, is_final);
+    transitions_.resize(transitions_.size() + automaton_.GetAlphabetSize(), Unknown_state);
+
+    return static_cast<state_t>(state);
+}
+
+LazyDFA::state_t LazyDFA::GetStartState()
+{
+    ++current_mark_;
+    new_state_.assign(1, automaton_.GetStartState());
+    CloseOverEpsilons(new_state_);
+
+    return AddState(new_state_);
+}
+
+void LazyDFA::Flush()
+{
+    subsets_.Clear();
+    transitions_.clear();
+    ++number_of_flushes_;
+}
+
+void LazyDFA::Move(std::span<const size_t> subset, FlatAutomaton::symbol_t symbol, std::vector<size_t> &result)
+{
+    ++current_mark_;
+    result.clear();
+
+    for (auto nfa_state : subset)
+    {
+        for (auto neighbour : automaton_.GetTargets(static_cast<FlatAutomaton::state_t>(nfa_state), symbol))
+        {
+            if (visit_marks_[neighbour] == current_mark_)
+                continue;
+
+            visit_marks_[neighbour] = current_mark_;
+            result.push_back(neighbour);
+        }
+    }
+
+    CloseOverEpsilons(result);
+}
+
+// Extends the subset by its epsilon closure and sorts it. States already in
+// the subset must not be marked with an older mark than current_mark_.
+void LazyDFA::CloseOverEpsilons(std::vector<size_t> &subset)
+{
+    for (auto nfa_state : subset)
+        visit_marks_[nfa_state] = current_mark_;
+
+    closure_stack_.assign(subset.begin(), subset.end());
+    while (!closure_stack_.empty())
+    {
+        auto nfa_state = static_cast<FlatAutomaton::state_t>(closure_stack_.back());
+        closure_stack_.pop_back();
+
+        for (auto neighbour : automaton_.GetTargets(nfa_state, automaton_.GetEpsilonSymbol()))
+        {
+            if (visit_marks_[neighbour] == current_mark_)
+                continue;
+
+            visit_marks_[neighbour] = current_mark_;
+            subset.push_back(neighbour);
+            closure_stack_.push_back(neighbour);
+        }
+    }
+
+    std::sort(subset.begin(), subset.end());
+}
+
+bool LazyDFA::SimulateNFA(std::vector<size_t> subset, std::string_view input)
+{
+    std::vector<size_t> next_subset;
+
+    for (auto letter : input)
+    {
+        auto symbol = symbols_[static_cast<unsigned char>(letter)];
+        if (symbol == FlatAutomaton::NoSymbol)
+            return false;
+
+        Move(subset, symbol, next_subset);
+        if (next_subset.empty())
+            return false;
+
+        subset.swap(next_subset);
+    }
+
+    return std::any_of(subset.begin(), subset.end(),
+                       [this](size_t nfa_state)
+                       {
+                           return automaton_.IsStateFinal(static_cast<FlatAutomaton::state_t>(nfa_state));
+                       });
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "automaton.hpp"
+#include "flat_automaton.hpp"
+#include "subset_table.hpp"
+
+// Determinizes an NFA while scanning the input: subset states and their
+// transitions are created on demand and cached. When the cache outgrows its
+// memory budget it is flushed, and if flushes come too often for the amount of
+// input they serve, the rest of the input is matched by NFA simulation.
+// Matching mutates the cache, so one object must not be shared between threads.
+class LazyDFA
+{
+    public:
+        static const size_t Default_memory_budget = 8 << 20;
+
+        explicit LazyDFA(const Automaton &automaton, size_t memory_budget = Default_memory_budget);
+
+        bool Accepts(std::string_view input);
+
+        size_t GetNumberOfCachedStates() const;
+        size_t GetMemoryUsage() const;
+        size_t GetNumberOfFlushes() const;
+        size_t GetNumberOfFallbacks() const;
+
+    private:
+        using state_t = uint32_t;
+
+        FlatAutomaton automaton_;
+        std::array<FlatAutomaton::symbol_t, 256> symbols_;
+
+        size_t memory_budget_;
+
+        SubsetTable subsets_;
+        std::vector<state_t> transitions_;
+
+        size_t number_of_flushes_ = 0;
+        size_t number_of_fallbacks_ = 0;
+        size_t bytes_since_flush_ = 0;
+
+        std::vector<size_t> visit_marks_;
+        size_t current_mark_ = 0;
+        std::vector<size_t> closure_stack_;
+        std::vector<size_t> new_state_;
+        std::vector<size_t> old_state_;
+
+        state_t AddState(std::vector<size_t> &subset);
+        state_t GetStartState();
+        void Flush();
+
+        void Move(std::span<const size_t> subset, FlatAutomaton::symbol_t symbol, std::vector<size_t> &result);
+        void CloseOverEpsilons(std::vector<size_t> &subset);
+
+        bool SimulateNFA(std::vector<size_t> subset, std::string_view input);
+};
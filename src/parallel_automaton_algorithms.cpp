@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <iostream>
+
+#include "automaton_algorithms.hpp"
+#include "automaton_statistics.hpp"
+#include "parallel_phases.hpp"
+#include "subset_table.hpp"
+
+namespace
+{
+    struct SubsetTransition
+    {
+        size_t state;
+        size_t symbol;
+
+        size_t offset;
+        size_t size;
+        uint64_t hash;
+
+        size_t target;
+        bool is_final;
+    };
+
+    struct SubsetWorkerData
+    {
+        std::vector<size_t> elements;
+        std::vector<SubsetTransition> transitions;
+
+        std::vector<size_t> visit_marks;
+        size_t current_mark = 0;
+    };
+};
+
+// Subsets are expanded one BFS level at a time. Workers compute the successors
+// of a contiguous part of the level and look them up in the subset table,
+// which is read-only during that phase. Then the new subsets are interned by
+// one thread in (state, letter) order, which gives the same numbering as the
+// sequential DFAFromNFA.
+DenseDFA AutomatonTransformer::ParallelDFAFromNFA(const FlatAutomaton &automaton, size_t number_of_threads)
+{
+    number_of_threads = ParallelPhases::GetNumberOfThreads(number_of_threads);
+    if (number_of_threads == 1)
+        return DFAFromNFA(automaton);
+
+    AUTOMATON_STAGE("ParallelDFAFromNFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    DenseDFA DFA(automaton.GetAlphabet(), 0);
+
+    size_t start_state = automaton.GetStartState();
+    SubsetTable subsets;
+    subsets.Insert(std::vector<size_t>{start_state}, automaton.IsStateFinal(automaton.GetStartState()));
+    DFA.SetFinal(DFA.AddState(), subsets.IsFinal(0));
+
+    std::vector<size_t> accept_ids;
+    if (automaton.HasAcceptIds())
+    {
+        automaton.CollectAcceptIds(subsets.GetSubset(0), accept_ids);
+        DFA.SetAcceptIds(0, accept_ids);
+    }
+
+    size_t level_begin = 0;
+    size_t level_end = 1;
+
+    std::vector<SubsetWorkerData> workers(number_of_threads);
+    for (auto &worker : workers)
+        worker.visit_marks.assign(automaton.GetNumberOfStates(), 0);
+
+    std::vector<uint8_t> useful;
+    GetUsefulStates(automaton, useful);
+
+    auto expand = [&](size_t thread_index)
+    {
+        auto &data = workers[thread_index];
+        data.elements.clear();
+        data.transitions.clear();
+
+        size_t level_size = level_end - level_begin;
+        size_t first = level_begin + ParallelPhases::GetRangeBegin(level_size, thread_index, number_of_threads);
+        size_t last = level_begin + ParallelPhases::GetRangeBegin(level_size, thread_index + 1, number_of_threads);
+
+        for (size_t state = first; state < last; ++state)
+        {
+            auto old_state = subsets.GetSubset(state);
+
+            for (FlatAutomaton::symbol_t symbol = 0; symbol < automaton.GetAlphabetSize(); ++symbol)
+            {
+                ++data.current_mark;
+                size_t offset = data.elements.size();
+                uint64_t hash = 0;
+
+                for (auto state_in_new_state : old_state)
+                {
+                    for (auto neighbour : automaton.GetTargets(static_cast<FlatAutomaton::state_t>(state_in_new_state), symbol))
+                    {
+                        if (data.visit_marks[neighbour] == data.current_mark || !useful[neighbour])
+                            continue;
+
+                        data.visit_marks[neighbour] = data.current_mark;
+                        data.elements.push_back(neighbour);
+                        hash += SubsetTable::HashElement(neighbour);
+                    }
+                }
+
+                size_t size = data.elements.size() - offset;
+                if (size == 0)
+                    continue;
+
+                auto new_state = std::span<size_t>(data.elements).subspan(offset, size);
+                std::sort(new_state.begin(), new_state.end());
+                hash = SubsetTable::FinalizeHash(hash, size);
+
+                size_t target = subsets.Find(new_state, hash);
+                bool is_final = target == SubsetTable::NotFound &&
+                                std::any_of(new_state.begin(), new_state.end(),
+                                            [&automaton](size_t neighbour)
+                                            {
+                                                return automaton.IsStateFinal(static_cast<FlatAutomaton::state_t>(neighbour));
+                                            });
+
+                data.transitions.push_back({state, symbol, offset, size, hash, target, is_final});
+            }
+        }
+    };
+
+    auto intern = [&]()
+    {
+        for (auto &data : workers)
+        {
+            for (auto &transition : data.transitions)
+            {
+                size_t target = transition.target;
+                if (target == SubsetTable::NotFound)
+                {
+                    auto new_state = std::span<const size_t>(data.elements).subspan(transition.offset, transition.size);
+
+                    size_t old_size = subsets.Size();
+                    target = subsets.Insert(new_state, transition.hash, transition.is_final);
+                    if (subsets.Size() != old_size)
+                    {
+                        DFA.SetFinal(DFA.AddState(), transition.is_final);
+
+                        if (automaton.HasAcceptIds())
+                        {
+                            automaton.CollectAcceptIds(new_state, accept_ids);
+                            DFA.SetAcceptIds(static_cast<DenseDFA::state_t>(target), accept_ids);
+                        }
+                    }
+                }
+
+                DFA.SetTransition(static_cast<DenseDFA::state_t>(transition.state), transition.symbol,
+                                  static_cast<DenseDFA::state_t>(target));
+            }
+        }
+
+        level_begin = level_end;
+        level_end = subsets.Size();
+
+        return level_begin != level_end;
+    };
+
+    ParallelPhases::Run(number_of_threads, expand, intern);
+
+    AUTOMATON_STAGE_OUTPUT(DFA);
+    return DFA;
+}
+
+Automaton AutomatonTransformer::ParallelDFAFromNFA(const Automaton &automaton, size_t number_of_threads)
+{
+    return ParallelDFAFromNFA(FlatAutomaton(automaton), number_of_threads).ToAutomaton(automaton.GetMemoryResource());
+}
+
+// Moore refinement where every round runs in three phases: the workers write
+// the signatures of their states into one preallocated table and sort them
+// into shards by hash, then every worker groups the signatures of its own
+// shard, and after classes are numbered by their first state the workers
+// update the classes of their states.
+DenseDFA AutomatonTransformer::ParallelMCDFAFromCDFA(const DenseDFA &automaton, size_t number_of_threads)
+{
+    if (!automaton.IsComplete())
+    {
+        std::cerr << "Automaton is not complete. It will be completed before minimization.\n";
+        return ParallelMCDFAFromCDFA(CDFAFromDFA(automaton), number_of_threads);
+    }
+
+    std::vector<uint8_t> reachable;
+    if (GetReachableStates(automaton, reachable) < automaton.GetNumberOfStates())
+        return ParallelMCDFAFromCDFA(RestrictDFA(automaton, reachable), number_of_threads);
+
+    number_of_threads = ParallelPhases::GetNumberOfThreads(number_of_threads);
+
+    AUTOMATON_STAGE("ParallelMCDFAFromCDFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    size_t number_of_states = automaton.GetNumberOfStates();
+    size_t alphabet_size = automaton.GetAlphabetSize();
+    size_t row_size = alphabet_size + 1;
+
+    std::vector<uint32_t> classes;
+    size_t cur_classes = automaton.GetAcceptClasses(classes);
+
+    std::vector<uint32_t> factor_set(number_of_states * row_size);
+    std::vector<uint64_t> hashes(number_of_states);
+    std::vector<uint32_t> representatives(number_of_states);
+    std::vector<uint32_t> new_classes(number_of_states);
+
+    std::vector<std::vector<std::vector<uint32_t>>> shards(number_of_threads,
+                                                           std::vector<std::vector<uint32_t>>(number_of_threads));
+    std::vector<std::vector<uint32_t>> shard_slots(number_of_threads);
+
+    size_t old_number_of_classes = 0;
+    size_t phase = 0;
+
+    auto refine = [&](size_t thread_index)
+    {
+        size_t first = ParallelPhases::GetRangeBegin(number_of_states, thread_index, number_of_threads);
+        size_t last = ParallelPhases::GetRangeBegin(number_of_states, thread_index + 1, number_of_threads);
+
+        if (phase == 0)
+        {
+            for (auto &shard : shards[thread_index])
+                shard.clear();
+
+            for (size_t state = first; state < last; ++state)
+            {
+                uint32_t *row = factor_set.data() + state * row_size;
+                row[0] = classes[state];
+
+                auto transitions = automaton.GetRow(static_cast<DenseDFA::state_t>(state));
+                for (size_t symbol = 0; symbol < alphabet_size; ++symbol)
+                    row[symbol + 1] = classes[transitions[symbol]];
+
+                hashes[state] = SubsetTable::HashSequence(std::span<const uint32_t>(row, row_size));
+                shards[thread_index][hashes[state] % number_of_threads].push_back(static_cast<uint32_t>(state));
+            }
+        }
+        else if (phase == 1)
+        {
+            size_t shard_size = 0;
+            for (auto &thread_shards : shards)
+                shard_size += thread_shards[thread_index].size();
+
+            size_t capacity = 16;
+            while (capacity < 2 * shard_size)
+                capacity *= 2;
+
+            auto &slots = shard_slots[thread_index];
+            slots.assign(capacity, DenseDFA::NoState);
+            size_t mask = capacity - 1;
+
+            // Shards of the threads hold increasing ranges of states, so the
+            // first state of every class becomes its representative.
+            for (auto &thread_shards : shards)
+            {
+                for (auto state : thread_shards[thread_index])
+                {
+                    std::span<const uint32_t> row(factor_set.data() + state * row_size, row_size);
+
+                    size_t slot = (hashes[state] / number_of_threads) & mask;
+                    while (slots[slot] != DenseDFA::NoState)
+                    {
+                        std::span<const uint32_t> other(factor_set.data() + slots[slot] * row_size, row_size);
+                        if (std::equal(row.begin(), row.end(), other.begin()))
+                            break;
+
+                        slot = (slot + 1) & mask;
+                    }
+
+                    if (slots[slot] == DenseDFA::NoState)
+                        slots[slot] = state;
+
+                    representatives[state] = slots[slot];
+                }
+            }
+        }
+        else
+        {
+            // The completion step runs on any of the threads, so the round is
+            // reported by thread 0, which runs the stage.
+            if (thread_index == 0)
+            {
+                AUTOMATON_COUNT(RefinementRounds, 1);
+                AUTOMATON_CLASSES(cur_classes);
+            }
+
+            for (size_t state = first; state < last; ++state)
+                classes[state] = new_classes[representatives[state]];
+        }
+    };
+
+    auto next_phase = [&]()
+    {
+        if (phase == 1)
+        {
+            old_number_of_classes = cur_classes;
+            cur_classes = 0;
+            for (size_t state = 0; state < number_of_states; ++state)
+            {
+                if (representatives[state] == state)
+                    new_classes[state] = static_cast<uint32_t>(cur_classes++);
+            }
+        }
+
+        phase = (phase + 1) % 3;
+
+        return phase != 0 || cur_classes != old_number_of_classes;
+    };
+
+    ParallelPhases::Run(number_of_threads, refine, next_phase);
+
+    auto minimal = QuotientOfDFA(automaton, classes, cur_classes);
+    AUTOMATON_STAGE_OUTPUT(minimal);
+    return minimal;
+}
+
+Automaton AutomatonTransformer::ParallelMCDFAFromCDFA(const Automaton &automaton, size_t number_of_threads)
+{
+    return ParallelMCDFAFromCDFA(DenseDFA(automaton), number_of_threads).ToAutomaton(automaton.GetMemoryResource());
+}
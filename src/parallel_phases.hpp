@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <barrier>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "automaton_statistics.hpp"
+
+namespace ParallelPhases
+{
+    // 0 means every hardware thread.
+    inline size_t GetNumberOfThreads(size_t number_of_threads)
+    {
+        if (number_of_threads == 0)
+            number_of_threads = std::thread::hardware_concurrency();
+
+        return std::max<size_t>(number_of_threads, 1);
+    }
+
+    // Runs worker(thread_index) on every thread of a pool. The completion step
+    // runs on one thread between the phases, and the workers stop as soon as
+    // it returns false. Thread 0 is the calling thread, and the statistics
+    // counted by the other threads are added to its counters at the end.
+    template <class Worker, class Completion>
+    void Run(size_t number_of_threads, Worker worker, Completion completion)
+    {
+        bool running = true;
+        auto on_completion = [&running, &completion]() noexcept { running = completion(); };
+        std::barrier phase_barrier(static_cast<std::ptrdiff_t>(number_of_threads), on_completion);
+
+        std::vector<AutomatonStatistics::counters_t> thread_counters(AutomatonStatistics::IsEnabled() ? number_of_threads : 0);
+
+        auto thread_loop = [&](size_t thread_index)
+        {
+            AutomatonStatistics::counters_t counters_at_start = {};
+            if constexpr (AutomatonStatistics::IsEnabled())
+                counters_at_start = AutomatonStatistics::GetThreadCounters();
+
+            while (running)
+            {
+                worker(thread_index);
+                phase_barrier.arrive_and_wait();
+            }
+
+            if constexpr (AutomatonStatistics::IsEnabled())
+            {
+                auto counters = AutomatonStatistics::GetThreadCounters();
+                for (size_t counter = 0; counter < counters.size(); ++counter)
+                    thread_counters[thread_index][counter] = counters[counter] - counters_at_start[counter];
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t thread_index = 1; thread_index < number_of_threads; ++thread_index)
+            threads.emplace_back(thread_loop, thread_index);
+
+        thread_loop(0);
+
+        for (auto &thread : threads)
+            thread.join();
+
+        if constexpr (AutomatonStatistics::IsEnabled())
+        {
+            for (size_t thread_index = 1; thread_index < number_of_threads; ++thread_index)
+                AutomatonStatistics::AddCounters(thread_counters[thread_index]);
+        }
+    }
+
+    // Bounds of the part of [0, size) processed by the thread.
+    inline size_t GetRangeBegin(size_t size, size_t thread_index, size_t number_of_threads)
+    {
+        return size * thread_index / number_of_threads;
+    }
+};
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <iterator>
+
+#include "automaton_algorithms.hpp"
+#include "subset_table.hpp"
+
+namespace
+{
+    const uint64_t Empty_key = ~uint64_t(0);
+
+    // Open addressing map from pairs of states packed into one word to the
+    // states of the product.
+    class PairTable
+    {
+        public:
+            PairTable():
+                keys_(16, Empty_key),
+                values_(16, 0),
+                size_(0)
+            {}
+
+            static uint64_t GetKey(DenseDFA::state_t first, DenseDFA::state_t second)
+            {
+                return (uint64_t(first) << 32) | second;
+            }
+
+            // Returns the value of the key, inserting value if the key is new.
+            uint32_t Insert(uint64_t key, uint32_t value)
+            {
+                if (2 * (size_ + 1) > keys_.size())
+                    Grow();
+
+                size_t slot = FindSlot(key);
+                if (keys_[slot] == Empty_key)
+                {
+                    keys_[slot] = key;
+                    values_[slot] = value;
+                    ++size_;
+                }
+
+                return values_[slot];
+            }
+
+        private:
+            std::vector<uint64_t> keys_;
+            std::vector<uint32_t> values_;
+            size_t size_;
+
+            size_t FindSlot(uint64_t key) const
+            {
+                size_t mask = keys_.size() - 1;
+                size_t slot = SubsetTable::HashElement(key) & mask;
+                while (keys_[slot] != Empty_key && keys_[slot] != key)
+                    slot = (slot + 1) & mask;
+
+                return slot;
+            }
+
+            void Grow()
+            {
+                std::vector<uint64_t> old_keys(2 * keys_.size(), Empty_key);
+                std::vector<uint32_t> old_values(2 * keys_.size(), 0);
+                old_keys.swap(keys_);
+                old_values.swap(values_);
+
+                for (size_t slot = 0; slot < old_keys.size(); ++slot)
+                {
+                    if (old_keys[slot] == Empty_key)
+                        continue;
+
+                    size_t new_slot = FindSlot(old_keys[slot]);
+                    keys_[new_slot] = old_keys[slot];
+                    values_[new_slot] = old_values[slot];
+                }
+            }
+    };
+
+    // States from which a final state is reachable.
+    std::vector<uint8_t> GetLiveStates(const DenseDFA &automaton)
+    {
+        size_t number_of_states = automaton.GetNumberOfStates();
+        size_t alphabet_size = automaton.GetAlphabetSize();
+
+        std::vector<uint32_t> inverse_offsets(number_of_states + 1, 0);
+        for (DenseDFA::state_t state = 0; state < number_of_states; ++state)
+        {
+            for (auto target : automaton.GetRow(state))
+            {
+                if (target != DenseDFA::NoState)
+                    ++inverse_offsets[target + 1];
+            }
+        }
+
+        for (size_t state = 1; state <= number_of_states; ++state)
+            inverse_offsets[state] += inverse_offsets[state - 1];
+
+        std::vector<uint32_t> inverse_sources(inverse_offsets.back());
+        std::vector<uint32_t> fill_positions(inverse_offsets.begin(), inverse_offsets.end() - 1);
+        for (DenseDFA::state_t state = 0; state < number_of_states; ++state)
+        {
+            for (size_t symbol = 0; symbol < alphabet_size; ++symbol)
+            {
+                auto target = automaton.GetTransition(state, symbol);
+                if (target != DenseDFA::NoState)
+                    inverse_sources[fill_positions[target]++] = state;
+            }
+        }
+
+        std::vector<uint8_t> live(number_of_states, false);
+        std::vector<uint32_t> queue;
+        for (DenseDFA::state_t state = 0; state < number_of_states; ++state)
+        {
+            if (automaton.IsStateFinal(state))
+            {
+                live[state] = true;
+                queue.push_back(state);
+            }
+        }
+
+        for (size_t index = 0; index < queue.size(); ++index)
+        {
+            auto state = queue[index];
+            for (uint32_t edge = inverse_offsets[state]; edge < inverse_offsets[state + 1]; ++edge)
+            {
+                auto source = inverse_sources[edge];
+                if (!live[source])
+                {
+                    live[source] = true;
+                    queue.push_back(source);
+                }
+            }
+        }
+
+        return live;
+    }
+
+    // Drops the states which can't reach a final state, keeping the order of the
+    // others. An empty language becomes one non-final state.
+    DenseDFA RemoveDeadStates(const DenseDFA &automaton)
+    {
+        auto live = GetLiveStates(automaton);
+        if (std::all_of(live.begin(), live.end(), [](uint8_t is_live) { return is_live; }))
+            return automaton;
+
+        DenseDFA result(automaton.GetAlphabet(), 0);
+        if (!live[automaton.GetStartState()])
+        {
+            result.AddState();
+            return result;
+        }
+
+        std::vector<DenseDFA::state_t> new_states(automaton.GetNumberOfStates(), DenseDFA::NoState);
+        for (DenseDFA::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+        {
+            if (live[state])
+                new_states[state] = result.AddState();
+        }
+
+        result.SetStartState(new_states[automaton.GetStartState()]);
+        for (DenseDFA::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+        {
+            if (!live[state])
+                continue;
+
+            result.SetFinal(new_states[state], automaton.IsStateFinal(state));
+            for (size_t symbol = 0; symbol < automaton.GetAlphabetSize(); ++symbol)
+            {
+                auto target = automaton.GetTransition(state, symbol);
+                if (target != DenseDFA::NoState)
+                    result.SetTransition(new_states[state], symbol, new_states[target]);
+            }
+        }
+
+        return result;
+    }
+
+    // Symbol of every letter of the alphabet in the automaton, or NoSymbol.
+    std::vector<size_t> GetSymbolMap(const std::vector<Automaton::alpha_t> &alphabet, const DenseDFA &automaton)
+    {
+        auto &own_alphabet = automaton.GetAlphabet();
+
+        std::vector<size_t> symbols(alphabet.size(), FlatAutomaton::NoSymbol);
+        for (size_t symbol = 0; symbol < alphabet.size(); ++symbol)
+        {
+            auto position = std::lower_bound(own_alphabet.begin(), own_alphabet.end(), alphabet[symbol]);
+            if (position != own_alphabet.end() && *position == alphabet[symbol])
+                symbols[symbol] = static_cast<size_t>(position - own_alphabet.begin());
+        }
+
+        return symbols;
+    }
+
+    bool IsProductFinal(AutomatonTransformer::ProductOperation operation, bool is_first_final, bool is_second_final)
+    {
+        switch (operation)
+        {
+            case AutomatonTransformer::ProductOperation::Intersection:
+                return is_first_final && is_second_final;
+
+            case AutomatonTransformer::ProductOperation::Union:
+                return is_first_final || is_second_final;
+
+            case AutomatonTransformer::ProductOperation::Difference:
+                return is_first_final && !is_second_final;
+
+            case AutomatonTransformer::ProductOperation::SymmetricDifference:
+                return is_first_final != is_second_final;
+
+            default:
+                return false;
+        }
+    }
+
+    // A pair can reach a final state only if the components the operation
+    // needs are alive. Dead components are already replaced by NoState.
+    bool IsProductAlive(AutomatonTransformer::ProductOperation operation, DenseDFA::state_t first, DenseDFA::state_t second)
+    {
+        switch (operation)
+        {
+            case AutomatonTransformer::ProductOperation::Intersection:
+                return first != DenseDFA::NoState && second != DenseDFA::NoState;
+
+            case AutomatonTransformer::ProductOperation::Difference:
+                return first != DenseDFA::NoState;
+
+            case AutomatonTransformer::ProductOperation::Union:
+            case AutomatonTransformer::ProductOperation::SymmetricDifference:
+            default:
+                return first != DenseDFA::NoState || second != DenseDFA::NoState;
+        }
+    }
+};
+
+// Only the pairs reachable from the pair of start states are built. The
+// operands are minimized first, so pairs whose components are equivalent are
+// the same pair; minimizing them is cheap next to the product of their sizes.
+// Dead states of the operands are replaced by NoState, so pairs that differ
+// only in a dead component are merged and pairs with a dead component the
+// operation needs are never created.
+DenseDFA AutomatonTransformer::ProductOfDFA(const DenseDFA &first_operand, const DenseDFA &second_operand,
+                                            ProductOperation operation)
+{
+    auto first = MCDFAFromCDFA(CDFAFromDFA(first_operand));
+    auto second = MCDFAFromCDFA(CDFAFromDFA(second_operand));
+
+    std::vector<Automaton::alpha_t> alphabet;
+    std::set_union(first.GetAlphabet().begin(), first.GetAlphabet().end(),
+                   second.GetAlphabet().begin(), second.GetAlphabet().end(), std::back_inserter(alphabet));
+
+    auto first_symbols = GetSymbolMap(alphabet, first);
+    auto second_symbols = GetSymbolMap(alphabet, second);
+
+    auto first_live = GetLiveStates(first);
+    auto second_live = GetLiveStates(second);
+
+    auto first_step = [&](DenseDFA::state_t state, size_t symbol)
+    {
+        if (state == DenseDFA::NoState || first_symbols[symbol] == FlatAutomaton::NoSymbol)
+            return DenseDFA::NoState;
+
+        auto target = first.GetTransition(state, first_symbols[symbol]);
+        return target != DenseDFA::NoState && first_live[target] ? target : DenseDFA::NoState;
+    };
+
+    auto second_step = [&](DenseDFA::state_t state, size_t symbol)
+    {
+        if (state == DenseDFA::NoState || second_symbols[symbol] == FlatAutomaton::NoSymbol)
+            return DenseDFA::NoState;
+
+        auto target = second.GetTransition(state, second_symbols[symbol]);
+        return target != DenseDFA::NoState && second_live[target] ? target : DenseDFA::NoState;
+    };
+
+    DenseDFA product(alphabet, 0);
+    product.AddState();
+
+    auto first_start = first_live[first.GetStartState()] ? first.GetStartState() : DenseDFA::NoState;
+    auto second_start = second_live[second.GetStartState()] ? second.GetStartState() : DenseDFA::NoState;
+    if (!IsProductAlive(operation, first_start, second_start))
+        return product;
+
+    std::vector<std::pair<DenseDFA::state_t, DenseDFA::state_t>> pairs = {{first_start, second_start}};
+    PairTable pair_states;
+    pair_states.Insert(PairTable::GetKey(first_start, second_start), 0);
+
+    for (DenseDFA::state_t state = 0; state < pairs.size(); ++state)
+    {
+        auto [first_state, second_state] = pairs[state];
+        product.SetFinal(state, IsProductFinal(operation,
+                                               first_state != DenseDFA::NoState && first.IsStateFinal(first_state),
+                                               second_state != DenseDFA::NoState && second.IsStateFinal(second_state)));
+
+        for (size_t symbol = 0; symbol < alphabet.size(); ++symbol)
+        {
+            auto first_target = first_step(first_state, symbol);
+            auto second_target = second_step(second_state, symbol);
+            if (!IsProductAlive(operation, first_target, second_target))
+                continue;
+
+            auto target = pair_states.Insert(PairTable::GetKey(first_target, second_target),
+                                             static_cast<uint32_t>(pairs.size()));
+            if (target == pairs.size())
+            {
+                pairs.push_back({first_target, second_target});
+                product.AddState();
+            }
+
+            product.SetTransition(state, symbol, target);
+        }
+    }
+
+    // Pairs of live states may still be unable to reach a final state together.
+    return RemoveDeadStates(product);
+}
+
+Automaton AutomatonTransformer::ProductOfDFA(const Automaton &first, const Automaton &second, ProductOperation operation)
+{
+    return ProductOfDFA(DenseDFA(first), DenseDFA(second), operation).ToAutomaton(first.GetMemoryResource());
+}
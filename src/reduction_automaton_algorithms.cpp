@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+
+#include "automaton_algorithms.hpp"
+#include "automaton_statistics.hpp"
+
+namespace
+{
+    const uint32_t No_class = std::numeric_limits<uint32_t>::max();
+
+    // (symbol, state) pairs of every state sorted by symbol: the targets of
+    // its edges, or the sources of its reversed edges.
+    using EdgeLists = std::vector<std::vector<std::pair<uint32_t, uint32_t>>>;
+
+    EdgeLists GetEdges(const FlatAutomaton &automaton, bool reversed)
+    {
+        EdgeLists edges(automaton.GetNumberOfStates());
+        for (FlatAutomaton::state_t state = 0; state < automaton.GetNumberOfStates(); ++state)
+        {
+            auto symbols = automaton.GetSymbols(state);
+            auto targets = automaton.GetTargets(state);
+            for (size_t edge = 0; edge < targets.size(); ++edge)
+            {
+                if (reversed)
+                    edges[targets[edge]].push_back({symbols[edge], state});
+                else
+                    edges[state].push_back({symbols[edge], targets[edge]});
+            }
+        }
+
+        if (reversed)
+        {
+            for (auto &state_edges : edges)
+                std::sort(state_edges.begin(), state_edges.end());
+        }
+
+        return edges;
+    }
+
+    Automaton::alpha_t GetLetter(const FlatAutomaton &automaton, FlatAutomaton::symbol_t symbol)
+    {
+        return symbol == automaton.GetEpsilonSymbol() ? Automaton::Epsilon : automaton.GetAlphabet()[symbol];
+    }
+
+    // Splits the classes until the states of every class have edges by the
+    // same symbols into the same classes. number_of_classes is the number of
+    // distinct initial classes. Classes are numbered in the order of their
+    // first state. Returns the number of classes.
+    size_t RefineBisimulation(const EdgeLists &edges, std::vector<uint32_t> &classes, size_t number_of_classes)
+    {
+        std::vector<uint32_t> new_classes(classes.size());
+        std::map<std::vector<uint32_t>, uint32_t> signature_classes;
+
+        std::vector<std::pair<uint32_t, uint32_t>> class_edges;
+        std::vector<uint32_t> signature;
+
+        while (true)
+        {
+            signature_classes.clear();
+            for (size_t state = 0; state < classes.size(); ++state)
+            {
+                class_edges.clear();
+                for (auto [symbol, neighbour] : edges[state])
+                    class_edges.push_back({symbol, classes[neighbour]});
+
+                std::sort(class_edges.begin(), class_edges.end());
+                class_edges.erase(std::unique(class_edges.begin(), class_edges.end()), class_edges.end());
+
+                signature.assign(1, classes[state]);
+                for (auto [symbol, neighbour_class] : class_edges)
+                {
+                    signature.push_back(symbol);
+                    signature.push_back(neighbour_class);
+                }
+
+                auto [position, inserted] = signature_classes.emplace(signature, static_cast<uint32_t>(signature_classes.size()));
+                new_classes[state] = position->second;
+            }
+
+            AUTOMATON_COUNT(RefinementRounds, 1);
+            AUTOMATON_CLASSES(signature_classes.size());
+
+            // The new classes split the old ones, so the same number of
+            // classes means the same partition.
+            classes.swap(new_classes);
+            if (signature_classes.size() == number_of_classes)
+                return number_of_classes;
+
+            number_of_classes = signature_classes.size();
+        }
+    }
+
+    // States with the same future are merged by forward bisimulation, which
+    // starts from final and other states. States with the same past are merged
+    // by backward bisimulation, which starts from the start state and the others.
+    void MergeBisimilarStates(Automaton &automaton, bool backward)
+    {
+        FlatAutomaton flat(automaton);
+
+        std::vector<uint32_t> classes(flat.GetNumberOfStates());
+        for (FlatAutomaton::state_t state = 0; state < flat.GetNumberOfStates(); ++state)
+            classes[state] = backward ? state == flat.GetStartState() : flat.IsStateFinal(state);
+
+        // A round that splits a single initial class must not look like a fixpoint.
+        auto number_of_marked = static_cast<size_t>(std::count(classes.begin(), classes.end(), 1u));
+        size_t number_of_classes = number_of_marked == 0 || number_of_marked == classes.size() ? 1 : 2;
+
+        number_of_classes = RefineBisimulation(GetEdges(flat, backward), classes, number_of_classes);
+        if (number_of_classes == flat.GetNumberOfStates())
+            return;
+
+        Automaton quotient(automaton.GetAlphabet(), number_of_classes, automaton.GetMemoryResource());
+        quotient.SetStartState(classes[flat.GetStartState()]);
+
+        for (FlatAutomaton::state_t state = 0; state < flat.GetNumberOfStates(); ++state)
+        {
+            if (flat.IsStateFinal(state))
+                quotient.SetFinal(classes[state]);
+
+            auto symbols = flat.GetSymbols(state);
+            auto targets = flat.GetTargets(state);
+            for (size_t edge = 0; edge < targets.size(); ++edge)
+                quotient.AddEdge(classes[state], classes[targets[edge]], GetLetter(flat, symbols[edge]));
+        }
+
+        automaton = std::move(quotient);
+    }
+
+    // simulated[first * n + second] tells that second simulates first: it is
+    // final if first is, and every edge of first has an edge of second by the
+    // same symbol into a state simulating its target. Starts from all pairs
+    // and drops the failing ones until nothing changes.
+    std::vector<uint8_t> GetSimulation(const FlatAutomaton &automaton)
+    {
+        size_t number_of_states = automaton.GetNumberOfStates();
+
+        std::vector<uint8_t> simulated(number_of_states * number_of_states);
+        for (FlatAutomaton::state_t first = 0; first < number_of_states; ++first)
+        {
+            for (FlatAutomaton::state_t second = 0; second < number_of_states; ++second)
+                simulated[first * number_of_states + second] = !automaton.IsStateFinal(first) || automaton.IsStateFinal(second);
+        }
+
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            AUTOMATON_COUNT(RefinementRounds, 1);
+
+            for (FlatAutomaton::state_t first = 0; first < number_of_states; ++first)
+            {
+                auto symbols = automaton.GetSymbols(first);
+                auto targets = automaton.GetTargets(first);
+
+                for (FlatAutomaton::state_t second = 0; second < number_of_states; ++second)
+                {
+                    if (first == second || !simulated[first * number_of_states + second])
+                        continue;
+
+                    for (size_t edge = 0; edge < targets.size(); ++edge)
+                    {
+                        auto second_targets = automaton.GetTargets(second, symbols[edge]);
+                        bool matched = std::any_of(second_targets.begin(), second_targets.end(),
+                                                   [&](FlatAutomaton::state_t second_target)
+                                                   {
+                                                       return simulated[targets[edge] * number_of_states + second_target];
+                                                   });
+
+                        if (!matched)
+                        {
+                            simulated[first * number_of_states + second] = false;
+                            changed = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        return simulated;
+    }
+
+    // States simulating each other have the same language, so they are
+    // merged. Then an edge is removed if the same state has an edge by the
+    // same symbol into a state strictly simulating its target: every word
+    // read after it is read after the other one too.
+    void ReduceBySimulation(Automaton &automaton)
+    {
+        FlatAutomaton flat(automaton);
+        size_t number_of_states = flat.GetNumberOfStates();
+        auto simulated = GetSimulation(flat);
+
+        // The first state of every class stands for it.
+        std::vector<uint32_t> classes(number_of_states, No_class);
+        std::vector<FlatAutomaton::state_t> representatives;
+        for (FlatAutomaton::state_t state = 0; state < number_of_states; ++state)
+        {
+            for (uint32_t state_class = 0; state_class < representatives.size(); ++state_class)
+            {
+                auto representative = representatives[state_class];
+                if (simulated[state * number_of_states + representative] && simulated[representative * number_of_states + state])
+                {
+                    classes[state] = state_class;
+                    break;
+                }
+            }
+
+            if (classes[state] == No_class)
+            {
+                classes[state] = static_cast<uint32_t>(representatives.size());
+                representatives.push_back(state);
+            }
+        }
+
+        EdgeLists class_edges(representatives.size());
+        for (FlatAutomaton::state_t state = 0; state < number_of_states; ++state)
+        {
+            auto symbols = flat.GetSymbols(state);
+            auto targets = flat.GetTargets(state);
+            for (size_t edge = 0; edge < targets.size(); ++edge)
+                class_edges[classes[state]].push_back({symbols[edge], classes[targets[edge]]});
+        }
+
+        Automaton reduced(automaton.GetAlphabet(), representatives.size(), automaton.GetMemoryResource());
+        reduced.SetStartState(classes[flat.GetStartState()]);
+
+        for (uint32_t state_class = 0; state_class < representatives.size(); ++state_class)
+        {
+            reduced.SetFinal(state_class, flat.IsStateFinal(representatives[state_class]));
+
+            auto &edges = class_edges[state_class];
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            for (auto [symbol, target] : edges)
+            {
+                // Distinct classes never simulate each other both ways.
+                auto same_symbol = std::equal_range(edges.begin(), edges.end(), std::pair<uint32_t, uint32_t>(symbol, 0),
+                                                    [](auto &first, auto &second) { return first.first < second.first; });
+                bool is_simulated = std::any_of(same_symbol.first, same_symbol.second, [&](auto &other_edge)
+                {
+                    return other_edge.second != target &&
+                           simulated[representatives[target] * number_of_states + representatives[other_edge.second]];
+                });
+
+                if (!is_simulated)
+                    reduced.AddEdge(state_class, target, GetLetter(flat, symbol));
+            }
+        }
+
+        automaton = std::move(reduced);
+        AutomatonTransformer::Trim(automaton);
+    }
+};
+
+Automaton AutomatonTransformer::ReduceNFA(const Automaton &automaton, NFAReduction reduction)
+{
+    AUTOMATON_STAGE("ReduceNFA");
+    AUTOMATON_STAGE_INPUT(automaton);
+
+    Automaton reduced(automaton, automaton.GetMemoryResource());
+
+    bool has_epsilons = std::any_of(automaton.GetStateNumbers().begin(), automaton.GetStateNumbers().end(),
+                                    [&automaton](size_t state) { return automaton.CanTransit(state, Automaton::Epsilon); });
+    if (has_epsilons)
+    {
+        std::cerr << "Automaton has epsilon transitions. They will be removed before the reduction.\n";
+        RemoveEpsTransitions(reduced);
+    }
+
+    Trim(reduced);
+
+    // Every merge can make more states equal in the other direction.
+    size_t number_of_states = 0;
+    do
+    {
+        number_of_states = reduced.GetNumberOfStates();
+
+        if (reduction == NFAReduction::Simulation)
+            ReduceBySimulation(reduced);
+
+        MergeBisimilarStates(reduced, false);
+        MergeBisimilarStates(reduced, true);
+    } while (reduced.GetNumberOfStates() < number_of_states);
+
+    AUTOMATON_STAGE_OUTPUT(reduced);
+    return reduced;
+}
@@ -0,0 +1,279 @@
+#include <cctype>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "automaton_algorithms.hpp"
+
+namespace
+{
+    const size_t Max_nesting_depth = 1000;
+    const std::string_view Empty_language = "[Empty language]";
+
+    // Reads a letter or a numeric symbol "[n]" starting at position.
+    bool ReadSymbol(std::string_view expression, size_t &position, Automaton::alpha_t &symbol)
+    {
+        unsigned char letter = static_cast<unsigned char>(expression[position]);
+        if (std::isalpha(letter))
+        {
+            symbol = static_cast<Automaton::alpha_t>(letter);
+            ++position;
+
+            return true;
+        }
+
+        if (letter != '[')
+            return false;
+
+        size_t end = position + 1;
+        long value = 0;
+        while (end < expression.size() && std::isdigit(static_cast<unsigned char>(expression[end])))
+        {
+            value = value * 10 + (expression[end] - '0');
+            if (value > std::numeric_limits<Automaton::alpha_t>::max())
+                return false;
+
+            ++end;
+        }
+
+        if (end == position + 1 || end == expression.size() || expression[end] != ']' || value == Automaton::Epsilon)
+            return false;
+
+        symbol = static_cast<Automaton::alpha_t>(value);
+        position = end + 1;
+
+        return true;
+    }
+
+    // Positions of a subexpression that can start and end its words.
+    struct Fragment
+    {
+        bool nullable = true;
+        std::vector<size_t> first = {};
+        std::vector<size_t> last = {};
+    };
+
+    // Glushkov construction done while parsing: every symbol occurrence is a
+    // state, and the edges between the last positions of one subexpression and
+    // the first positions of the next one are added as soon as a concatenation
+    // or a star is read, so no syntax tree is built.
+    class GlushkovParser
+    {
+        public:
+            GlushkovParser(std::string_view expression, Automaton &automaton, size_t number_of_positions):
+                expression_(expression),
+                position_(0),
+                depth_(0),
+                error_(nullptr),
+                error_position_(0),
+                automaton_(automaton),
+                symbols_(number_of_positions + 1, Automaton::Epsilon),
+                number_of_positions_(0)
+            {}
+
+            bool Parse()
+            {
+                Fragment expression = ParseUnion();
+                if (!error_ && Peek() != '\0')
+                    Fail(Peek() == ')' ? "Unbalanced ')'" : "Unexpected character");
+
+                if (error_)
+                {
+                    std::cerr << "Error in regular expression at position " << error_position_ << ": " << error_ << ".\n";
+                    return false;
+                }
+
+                size_t start = automaton_.GetStartState();
+                Connect(std::span<const size_t>(&start, 1), expression.first);
+
+                for (auto last : expression.last)
+                    automaton_.SetFinal(last);
+
+                automaton_.SetFinal(start, expression.nullable);
+
+                return true;
+            }
+
+        private:
+            std::string_view expression_;
+            size_t position_;
+            size_t depth_;
+            const char *error_;
+            size_t error_position_;
+
+            Automaton &automaton_;
+            std::vector<Automaton::alpha_t> symbols_;
+            size_t number_of_positions_;
+
+            char Peek()
+            {
+                while (position_ < expression_.size() && std::isspace(static_cast<unsigned char>(expression_[position_])))
+                    ++position_;
+
+                return position_ < expression_.size() ? expression_[position_] : '\0';
+            }
+
+            void Fail(const char *error)
+            {
+                if (error_)
+                    return;
+
+                error_ = error;
+                error_position_ = position_;
+            }
+
+            void Connect(std::span<const size_t> from, std::span<const size_t> to)
+            {
+                for (auto from_position : from)
+                {
+                    for (auto to_position : to)
+                        automaton_.AddEdge(from_position, to_position, symbols_[to_position]);
+                }
+            }
+
+            static void Append(std::vector<size_t> &positions, const std::vector<size_t> &other)
+            {
+                positions.insert(positions.end(), other.begin(), other.end());
+            }
+
+            Fragment ParseUnion()
+            {
+                if (++depth_ > Max_nesting_depth)
+                {
+                    Fail("Expression is nested too deeply");
+                    return {};
+                }
+
+                Fragment result = ParseConcatenation();
+                while (!error_ && Peek() == '+')
+                {
+                    ++position_;
+                    Fragment other = ParseConcatenation();
+
+                    result.nullable = result.nullable || other.nullable;
+                    Append(result.first, other.first);
+                    Append(result.last, other.last);
+                }
+
+                --depth_;
+                return result;
+            }
+
+            Fragment ParseConcatenation()
+            {
+                char next = Peek();
+                if (next == '\0' || next == '+' || next == ')')
+                {
+                    Fail("Expected an expression");
+                    return {};
+                }
+
+                Fragment result = ParseStar();
+                for (next = Peek(); !error_ && next != '\0' && next != '+' && next != ')'; next = Peek())
+                {
+                    Fragment other = ParseStar();
+                    if (error_)
+                        break;
+
+                    Connect(result.last, other.first);
+
+                    if (result.nullable)
+                        Append(result.first, other.first);
+
+                    if (other.nullable)
+                        Append(other.last, result.last);
+
+                    result.last = std::move(other.last);
+                    result.nullable = result.nullable && other.nullable;
+                }
+
+                return result;
+            }
+
+            Fragment ParseStar()
+            {
+                Fragment result = ParseAtom();
+
+                bool is_starred = false;
+                while (!error_ && Peek() == '*')
+                {
+                    ++position_;
+                    is_starred = true;
+                }
+
+                if (is_starred)
+                {
+                    Connect(result.last, result.first);
+                    result.nullable = true;
+                }
+
+                return result;
+            }
+
+            Fragment ParseAtom()
+            {
+                char next = Peek();
+                if (next == '(')
+                {
+                    ++position_;
+                    Fragment result = ParseUnion();
+
+                    if (Peek() != ')')
+                        Fail("Expected ')'");
+                    else
+                        ++position_;
+
+                    return result;
+                }
+
+                if (next == '1')
+                {
+                    ++position_;
+                    return {};
+                }
+
+                Automaton::alpha_t symbol = Automaton::Epsilon;
+                if (!ReadSymbol(expression_, position_, symbol))
+                {
+                    Fail("Expected a letter, a symbol [n], '1' or '('");
+                    return {};
+                }
+
+                size_t state = ++number_of_positions_;
+                symbols_[state] = symbol;
+
+                return {false, {state}, {state}};
+            }
+    };
+};
+
+Automaton AutomatonTransformer::AutomatonFromRegExpr(std::string_view expression, std::pmr::memory_resource *resource)
+{
+    std::set<Automaton::alpha_t> alphabet;
+    if (expression == Empty_language)
+        return Automaton(std::move(alphabet), 1, resource);
+    size_t number_of_positions = 0;
+
+    for (size_t position = 0; position < expression.size();)
+    {
+        Automaton::alpha_t symbol = Automaton::Epsilon;
+        if (ReadSymbol(expression, position, symbol))
+        {
+            alphabet.insert(symbol);
+            ++number_of_positions;
+        }
+        else
+        {
+            ++position;
+        }
+    }
+
+    Automaton automaton(alphabet, number_of_positions + 1, resource);
+    GlushkovParser parser(expression, automaton, number_of_positions);
+
+    if (!parser.Parse())
+        return Automaton(std::move(alphabet), 1, resource);
+
+    return automaton;
+}
@@ -0,0 +1,598 @@
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "regular_expression.hpp"
+#include "subset_table.hpp"
+
+namespace
+{
+    const RegularExpressionPool::node_t Empty_slot = std::numeric_limits<RegularExpressionPool::node_t>::max();
+    const size_t Initial_capacity = 64;
+
+    const uint64_t Max_length = uint64_t(1) << 62;
+    const size_t Max_factoring_depth = 32;
+    const size_t Simplification_work_per_node = 64;
+    const size_t Min_simplification_work = 4096;
+
+    uint64_t AddLengths(uint64_t first, uint64_t second) { return std::min(first + second, Max_length); }
+
+    uint64_t HashNode(RegularExpressionPool::Kind kind, RegularExpressionPool::node_t left, RegularExpressionPool::node_t right)
+    {
+        const uint32_t sequence[] = {static_cast<uint32_t>(kind), left, right};
+        return SubsetTable::HashSequence(sequence);
+    }
+};
+
+const RegularExpressionPool::node_t RegularExpressionPool::EmptySet = 0;
+const RegularExpressionPool::node_t RegularExpressionPool::EmptyWord = 1;
+
+RegularExpressionPool::RegularExpressionPool():
+    nodes_(),
+    slots_(Initial_capacity, Empty_slot),
+    mask_(Initial_capacity - 1),
+    work_left_(0)
+{
+    MakeNode(Kind::EmptySet, 0, 0);
+    MakeNode(Kind::EmptyWord, 0, 0);
+}
+
+RegularExpressionPool::node_t RegularExpressionPool::MakeSymbol(Automaton::alpha_t symbol)
+{
+    return MakeNode(Kind::Symbol, static_cast<node_t>(static_cast<uint16_t>(symbol)), 0);
+}
+
+RegularExpressionPool::node_t RegularExpressionPool::MakeUnion(node_t left, node_t right)
+{
+    if (left == EmptySet || left == right)
+        return right;
+
+    if (right == EmptySet)
+        return left;
+
+    return MakeNode(Kind::Union, left, right);
+}
+
+RegularExpressionPool::node_t RegularExpressionPool::MakeConcatenation(node_t left, node_t right)
+{
+    if (left == EmptySet || right == EmptySet)
+        return EmptySet;
+
+    if (left == EmptyWord)
+        return right;
+
+    if (right == EmptyWord)
+        return left;
+
+    return MakeNode(Kind::Concatenation, left, right);
+}
+
+RegularExpressionPool::node_t RegularExpressionPool::MakeStar(node_t node)
+{
+    if (node == EmptySet || node == EmptyWord)
+        return EmptyWord;
+
+    if (GetKind(node) == Kind::Star)
+        return node;
+
+    return MakeNode(Kind::Star, node, 0);
+}
+
+RegularExpressionPool::Kind RegularExpressionPool::GetKind(node_t node) const { return nodes_[node].kind; }
+
+RegularExpressionPool::node_t RegularExpressionPool::GetLeft(node_t node) const { return nodes_[node].left; }
+
+RegularExpressionPool::node_t RegularExpressionPool::GetRight(node_t node) const { return nodes_[node].right; }
+
+Automaton::alpha_t RegularExpressionPool::GetSymbol(node_t node) const
+{
+    return static_cast<Automaton::alpha_t>(static_cast<uint16_t>(nodes_[node].left));
+}
+
+bool RegularExpressionPool::IsNullable(node_t node) const { return nodes_[node].nullable; }
+
+uint64_t RegularExpressionPool::GetLength(node_t node) const { return nodes_[node].length; }
+
+size_t RegularExpressionPool::Size() const { return nodes_.size(); }
+
+RegularExpressionPool::node_t RegularExpressionPool::Simplify(node_t node)
+{
+    size_t number_of_nodes = nodes_.size();
+    work_left_ = std::max(Simplification_work_per_node * number_of_nodes, Min_simplification_work);
+
+    std::vector<node_t> simplified(number_of_nodes, Empty_slot);
+    std::vector<node_t> stack = {node};
+
+    while (!stack.empty())
+    {
+        node_t current = stack.back();
+        if (simplified[current] != Empty_slot)
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        Kind kind = GetKind(current);
+        if (kind == Kind::EmptySet || kind == Kind::EmptyWord || kind == Kind::Symbol)
+        {
+            simplified[current] = current;
+            stack.pop_back();
+            continue;
+        }
+
+        node_t left = GetLeft(current);
+        node_t right = kind == Kind::Star ? left : GetRight(current);
+        if (simplified[left] == Empty_slot || simplified[right] == Empty_slot)
+        {
+            if (simplified[left] == Empty_slot)
+                stack.push_back(left);
+
+            if (simplified[right] == Empty_slot)
+                stack.push_back(right);
+
+            continue;
+        }
+
+        stack.pop_back();
+
+        // Without work left the rest of the nodes are only rebuilt over the
+        // simplified children, so long unions aren't flattened again and again.
+        if (work_left_ == 0)
+        {
+            if (kind == Kind::Union)
+                simplified[current] = MakeUnion(simplified[left], simplified[right]);
+            else if (kind == Kind::Concatenation)
+                simplified[current] = MakeConcatenation(simplified[left], simplified[right]);
+            else
+                simplified[current] = MakeStar(simplified[left]);
+
+            continue;
+        }
+
+        switch (kind)
+        {
+            case Kind::Union:
+                simplified[current] = SimplifyUnion({simplified[left], simplified[right]}, 0);
+                break;
+
+            case Kind::Concatenation:
+                simplified[current] = SimplifyConcatenation(simplified[left], simplified[right]);
+                break;
+
+            case Kind::Star:
+                simplified[current] = SimplifyStar(simplified[left]);
+                break;
+
+            case Kind::EmptySet:
+            case Kind::EmptyWord:
+            case Kind::Symbol:
+            default:
+                simplified[current] = current;
+                break;
+        }
+    }
+
+    return simplified[node];
+}
+
+// Printed with an explicit stack, since long concatenations make deep DAGs.
+std::string RegularExpressionPool::ToString(node_t node) const
+{
+    struct Task
+    {
+        node_t node;
+        const char *text;
+    };
+
+    auto needs_brackets = [this](Kind parent, node_t child)
+    {
+        Kind kind = GetKind(child);
+        if (parent == Kind::Star)
+            return kind == Kind::Union || kind == Kind::Concatenation;
+
+        return parent == Kind::Concatenation && kind == Kind::Union;
+    };
+
+    std::string result;
+    std::vector<Task> tasks = {{node, nullptr}};
+
+    auto push_child = [&](Kind parent, node_t child)
+    {
+        if (needs_brackets(parent, child))
+        {
+            tasks.push_back({0, ")"});
+            tasks.push_back({child, nullptr});
+            tasks.push_back({0, "("});
+        }
+        else
+        {
+            tasks.push_back({child, nullptr});
+        }
+    };
+
+    while (!tasks.empty())
+    {
+        auto task = tasks.back();
+        tasks.pop_back();
+
+        if (task.text)
+        {
+            result += task.text;
+            continue;
+        }
+
+        switch (GetKind(task.node))
+        {
+            case Kind::EmptySet:
+                result += "0";
+                break;
+
+            case Kind::EmptyWord:
+                result += "1";
+                break;
+
+            case Kind::Symbol:
+            {
+                auto symbol = GetSymbol(task.node);
+                if (symbol >= 0 && symbol <= std::numeric_limits<unsigned char>::max() && std::isalpha(symbol))
+                    result += static_cast<char>(symbol);
+                else
+                    result += "[" + std::to_string(symbol) + "]";
+
+                break;
+            }
+
+            case Kind::Union:
+                tasks.push_back({GetRight(task.node), nullptr});
+                tasks.push_back({0, " + "});
+                tasks.push_back({GetLeft(task.node), nullptr});
+                break;
+
+            case Kind::Concatenation:
+                push_child(Kind::Concatenation, GetRight(task.node));
+                push_child(Kind::Concatenation, GetLeft(task.node));
+                break;
+
+            case Kind::Star:
+                tasks.push_back({0, "*"});
+                push_child(Kind::Star, GetLeft(task.node));
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return result;
+}
+
+RegularExpressionPool::node_t RegularExpressionPool::MakeNode(Kind kind, node_t left, node_t right)
+{
+    size_t slot = HashNode(kind, left, right) & mask_;
+    while (slots_[slot] != Empty_slot)
+    {
+        auto &other = nodes_[slots_[slot]];
+        if (other.kind == kind && other.left == left && other.right == right)
+            return slots_[slot];
+
+        slot = (slot + 1) & mask_;
+    }
+
+    node_t node = static_cast<node_t>(nodes_.size());
+    Node new_node = {kind, false, left, right, node, node, 1};
+
+    switch (kind)
+    {
+        case Kind::EmptyWord:
+            new_node.nullable = true;
+            break;
+
+        case Kind::Symbol:
+        {
+            auto symbol = static_cast<Automaton::alpha_t>(static_cast<uint16_t>(left));
+            if (!(symbol >= 0 && symbol <= std::numeric_limits<unsigned char>::max() && std::isalpha(symbol)))
+                new_node.length = std::to_string(symbol).size() + 2;
+
+            break;
+        }
+
+        case Kind::Union:
+            new_node.nullable = nodes_[left].nullable || nodes_[right].nullable;
+            new_node.length = AddLengths(AddLengths(nodes_[left].length, nodes_[right].length), 3);
+            break;
+
+        case Kind::Concatenation:
+            new_node.nullable = nodes_[left].nullable && nodes_[right].nullable;
+            new_node.first = nodes_[left].first;
+            new_node.last = nodes_[right].last;
+            new_node.length = AddLengths(nodes_[left].length, nodes_[right].length);
+            new_node.length = AddLengths(new_node.length, uint64_t(2) * (nodes_[left].kind == Kind::Union) + uint64_t(2) * (nodes_[right].kind == Kind::Union));
+            break;
+
+        case Kind::Star:
+        {
+            Kind child_kind = nodes_[left].kind;
+            new_node.nullable = true;
+            new_node.length = AddLengths(nodes_[left].length, 1 + uint64_t(2) * (child_kind == Kind::Union || child_kind == Kind::Concatenation));
+            break;
+        }
+
+        case Kind::EmptySet:
+        default:
+            break;
+    }
+
+    nodes_.push_back(new_node);
+    slots_[slot] = node;
+
+    if (2 * nodes_.size() > slots_.size())
+        Grow();
+
+    return node;
+}
+
+void RegularExpressionPool::Grow()
+{
+    slots_.assign(2 * slots_.size(), Empty_slot);
+    mask_ = slots_.size() - 1;
+
+    for (node_t node = 0; node < nodes_.size(); ++node)
+    {
+        size_t slot = HashNode(nodes_[node].kind, nodes_[node].left, nodes_[node].right) & mask_;
+        while (slots_[slot] != Empty_slot)
+            slot = (slot + 1) & mask_;
+
+        slots_[slot] = node;
+    }
+}
+
+bool RegularExpressionPool::Spend(size_t work)
+{
+    if (work_left_ < work)
+    {
+        work_left_ = 0;
+        return false;
+    }
+
+    work_left_ -= work;
+    return true;
+}
+
+void RegularExpressionPool::GetAlternatives(node_t node, std::vector<node_t> &alternatives)
+{
+    std::vector<node_t> stack = {node};
+    while (!stack.empty())
+    {
+        node_t current = stack.back();
+        stack.pop_back();
+        Spend(1);
+
+        if (GetKind(current) == Kind::Union)
+        {
+            stack.push_back(GetRight(current));
+            stack.push_back(GetLeft(current));
+        }
+        else
+        {
+            alternatives.push_back(current);
+        }
+    }
+}
+
+void RegularExpressionPool::GetFactors(node_t node, std::vector<node_t> &factors)
+{
+    std::vector<node_t> stack = {node};
+    while (!stack.empty())
+    {
+        node_t current = stack.back();
+        stack.pop_back();
+        Spend(1);
+
+        if (GetKind(current) == Kind::Concatenation)
+        {
+            stack.push_back(GetRight(current));
+            stack.push_back(GetLeft(current));
+        }
+        else
+        {
+            factors.push_back(current);
+        }
+    }
+}
+
+RegularExpressionPool::node_t RegularExpressionPool::RemoveFirstFactor(node_t node)
+{
+    std::vector<node_t> spine;
+    for (; GetKind(node) == Kind::Concatenation; node = GetLeft(node))
+        spine.push_back(node);
+
+    Spend(spine.size());
+
+    node_t rest = EmptyWord;
+    for (auto concatenation = spine.rbegin(); concatenation != spine.rend(); ++concatenation)
+        rest = MakeConcatenation(rest, GetRight(*concatenation));
+
+    return rest;
+}
+
+RegularExpressionPool::node_t RegularExpressionPool::RemoveLastFactor(node_t node)
+{
+    std::vector<node_t> spine;
+    for (; GetKind(node) == Kind::Concatenation; node = GetRight(node))
+        spine.push_back(node);
+
+    Spend(spine.size());
+
+    node_t rest = EmptyWord;
+    for (auto concatenation = spine.rbegin(); concatenation != spine.rend(); ++concatenation)
+        rest = MakeConcatenation(GetLeft(*concatenation), rest);
+
+    return rest;
+}
+
+RegularExpressionPool::node_t RegularExpressionPool::SimplifyUnion(std::vector<node_t> alternatives, size_t depth)
+{
+    std::vector<node_t> flat;
+    for (auto alternative : alternatives)
+        GetAlternatives(alternative, flat);
+
+    std::unordered_set<node_t> seen;
+    std::unordered_set<node_t> starred;
+    bool has_nullable = false;
+
+    alternatives.clear();
+    for (auto alternative : flat)
+    {
+        if (alternative == EmptySet || !seen.insert(alternative).second)
+            continue;
+
+        alternatives.push_back(alternative);
+        if (GetKind(alternative) == Kind::Star)
+            starred.insert(GetLeft(alternative));
+
+        has_nullable = has_nullable || (alternative != EmptyWord && IsNullable(alternative));
+    }
+
+    // r + r* = r* and 1 + r = r for a nullable r.
+    std::erase_if(alternatives, [&](node_t alternative)
+    {
+        return starred.contains(alternative) || (alternative == EmptyWord && has_nullable);
+    });
+
+    if (depth < Max_factoring_depth && alternatives.size() > 1)
+    {
+        alternatives = FactorAlternatives(alternatives, true, depth);
+        alternatives = FactorAlternatives(alternatives, false, depth);
+    }
+
+    node_t result = EmptySet;
+    for (auto alternative : alternatives)
+        result = MakeUnion(result, alternative);
+
+    return result;
+}
+
+// r*r* = r*.
+RegularExpressionPool::node_t RegularExpressionPool::SimplifyConcatenation(node_t left, node_t right)
+{
+    if (GetKind(left) == Kind::Star && nodes_[right].first == left)
+        return right;
+
+    if (GetKind(right) == Kind::Star && nodes_[left].last == right)
+        return left;
+
+    return MakeConcatenation(left, right);
+}
+
+// (1 + r* + st)* = (r + s + t)* if s and t are nullable.
+RegularExpressionPool::node_t RegularExpressionPool::SimplifyStar(node_t body)
+{
+    node_t star = MakeStar(body);
+    if (!Spend(1))
+        return star;
+
+    std::vector<node_t> parts;
+    std::vector<node_t> stack = {body};
+    std::vector<node_t> pieces;
+
+    while (!stack.empty() && work_left_ > 0)
+    {
+        node_t current = stack.back();
+        stack.pop_back();
+
+        pieces.clear();
+        switch (GetKind(current))
+        {
+            case Kind::EmptyWord:
+                break;
+
+            case Kind::Star:
+                stack.push_back(GetLeft(current));
+                break;
+
+            case Kind::Union:
+                GetAlternatives(current, pieces);
+                stack.insert(stack.end(), pieces.rbegin(), pieces.rend());
+                break;
+
+            case Kind::Concatenation:
+                if (!IsNullable(current))
+                {
+                    parts.push_back(current);
+                    break;
+                }
+
+                GetFactors(current, pieces);
+                stack.insert(stack.end(), pieces.rbegin(), pieces.rend());
+                break;
+
+            case Kind::EmptySet:
+            case Kind::Symbol:
+            default:
+                parts.push_back(current);
+                break;
+        }
+    }
+
+    if (!stack.empty())
+        return star;
+
+    node_t new_star = MakeStar(SimplifyUnion(parts, Max_factoring_depth));
+    return GetLength(new_star) <= GetLength(star) ? new_star : star;
+}
+
+// Alternatives with the same first (or last) factor are merged into the
+// factor concatenated with the union of the rests, if that is shorter.
+std::vector<RegularExpressionPool::node_t> RegularExpressionPool::FactorAlternatives(const std::vector<node_t> &alternatives,
+                                                                                      bool is_prefix, size_t depth)
+{
+    std::unordered_map<node_t, size_t> group_of_factor;
+    std::vector<std::vector<node_t>> groups;
+
+    for (auto alternative : alternatives)
+    {
+        node_t factor = is_prefix ? nodes_[alternative].first : nodes_[alternative].last;
+        auto [group, is_new] = group_of_factor.try_emplace(factor, groups.size());
+        if (is_new)
+            groups.emplace_back();
+
+        groups[group->second].push_back(alternative);
+    }
+
+    if (groups.size() == alternatives.size())
+        return alternatives;
+
+    std::vector<node_t> result;
+    std::vector<node_t> rests;
+
+    for (auto &group : groups)
+    {
+        if (group.size() == 1 || work_left_ == 0)
+        {
+            result.insert(result.end(), group.begin(), group.end());
+            continue;
+        }
+
+        node_t factor = is_prefix ? nodes_[group[0]].first : nodes_[group[0]].last;
+        uint64_t old_length = 3 * (group.size() - 1);
+
+        rests.clear();
+        for (auto alternative : group)
+        {
+            rests.push_back(is_prefix ? RemoveFirstFactor(alternative) : RemoveLastFactor(alternative));
+            old_length = AddLengths(old_length, GetLength(alternative));
+        }
+
+        node_t rest = SimplifyUnion(rests, depth + 1);
+        node_t merged = is_prefix ? SimplifyConcatenation(factor, rest) : SimplifyConcatenation(rest, factor);
+
+        if (GetLength(merged) < old_length)
+            result.push_back(merged);
+        else
+            result.insert(result.end(), group.begin(), group.end());
+    }
+
+    return result;
+}
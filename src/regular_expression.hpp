@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "automaton.hpp"
+
+// Regular expressions stored as a DAG of hash-consed nodes: a node with the
+// same operation and operands is created only once, so equal subexpressions
+// are shared and compared by index. Constructors drop the empty set and the
+// empty word where they are units or zeros of the operation.
+class RegularExpressionPool
+{
+    public:
+        using node_t = uint32_t;
+
+        enum class Kind : uint8_t
+        {
+            EmptySet,
+            EmptyWord,
+            Symbol,
+            Union,
+            Concatenation,
+            Star,
+        };
+
+        static const node_t EmptySet;
+        static const node_t EmptyWord;
+
+        RegularExpressionPool();
+
+        node_t MakeSymbol(Automaton::alpha_t symbol);
+        node_t MakeUnion(node_t left, node_t right);
+        node_t MakeConcatenation(node_t left, node_t right);
+        node_t MakeStar(node_t node);
+
+        Kind GetKind(node_t node) const;
+        node_t GetLeft(node_t node) const;
+        node_t GetRight(node_t node) const;
+        Automaton::alpha_t GetSymbol(node_t node) const;
+
+        bool IsNullable(node_t node) const;
+
+        // Length of the printed expression, saturated for huge expressions.
+        uint64_t GetLength(node_t node) const;
+
+        size_t Size() const;
+
+        // Rewrites the expression bottom-up: unions are flattened without
+        // duplicates, the empty word is dropped from unions with a nullable
+        // alternative, stars drop nullable parts of their bodies, and common
+        // prefixes and suffixes of alternatives are factored out. Every node
+        // is rewritten once, and the total work is limited by the size of the
+        // pool, so huge expressions are simplified only partially.
+        node_t Simplify(node_t node);
+
+        // Prints the expression in the notation of RegExpr with the brackets
+        // required by the precedence of star over concatenation over union.
+        std::string ToString(node_t node) const;
+
+    private:
+        struct Node
+        {
+            Kind kind;
+            bool nullable;
+
+            node_t left;
+            node_t right;
+
+            // First and last factors of a concatenation, the node itself otherwise.
+            node_t first;
+            node_t last;
+
+            uint64_t length;
+        };
+
+        std::vector<Node> nodes_;
+
+        std::vector<node_t> slots_;
+        size_t mask_;
+
+        size_t work_left_;
+
+        node_t MakeNode(Kind kind, node_t left, node_t right);
+        void Grow();
+
+        bool Spend(size_t work);
+
+        void GetAlternatives(node_t node, std::vector<node_t> &alternatives);
+        void GetFactors(node_t node, std::vector<node_t> &factors);
+        node_t RemoveFirstFactor(node_t node);
+        node_t RemoveLastFactor(node_t node);
+
+        node_t SimplifyUnion(std::vector<node_t> alternatives, size_t depth);
+        node_t SimplifyConcatenation(node_t left, node_t right);
+        node_t SimplifyStar(node_t body);
+        std::vector<node_t> FactorAlternatives(const std::vector<node_t> &alternatives, bool is_prefix, size_t depth);
+};
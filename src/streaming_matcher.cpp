@@ -0,0 +1,69 @@
+#include <string_view>
+
+#include "streaming_matcher.hpp"
+
+StreamingDFAMatcher::StreamingDFAMatcher(const CompiledDFA &automaton):
+    automaton_(automaton),
+    state_(automaton.GetStartState()),
+    offset_(0)
+{}
+
+void StreamingDFAMatcher::Reset()
+{
+    state_ = automaton_.GetStartState();
+    offset_ = 0;
+}
+
+void StreamingDFAMatcher::Feed(std::span<const char> chunk)
+{
+    if (state_ != automaton_.GetDeadState())
+        state_ = automaton_.Run(state_, std::string_view(chunk.data(), chunk.size()));
+
+    offset_ += chunk.size();
+}
+
+bool StreamingDFAMatcher::IsAccepting() const { return automaton_.IsAccepting(state_); }
+
+std::span<const uint32_t> StreamingDFAMatcher::GetAcceptIds() const { return automaton_.GetAcceptIds(state_); }
+
+bool StreamingDFAMatcher::IsDead() const { return state_ == automaton_.GetDeadState(); }
+
+uint64_t StreamingDFAMatcher::GetOffset() const { return offset_; }
+
+CompiledDFA::state_t StreamingDFAMatcher::GetState() const { return state_; }
+
+StreamingNFAMatcher::StreamingNFAMatcher(const BitParallelNFA &automaton):
+    automaton_(automaton),
+    active_(automaton.GetNumberOfWords()),
+    next_(automaton.GetNumberOfWords()),
+    is_dead_(false),
+    offset_(0)
+{
+    Reset();
+}
+
+void StreamingNFAMatcher::Reset()
+{
+    automaton_.Start(active_);
+    is_dead_ = false;
+    offset_ = 0;
+}
+
+void StreamingNFAMatcher::Feed(std::span<const char> chunk)
+{
+    for (size_t position = 0; position < chunk.size() && !is_dead_; ++position)
+    {
+        is_dead_ = !automaton_.Step(active_, static_cast<unsigned char>(chunk[position]), next_);
+        active_.swap(next_);
+    }
+
+    offset_ += chunk.size();
+}
+
+bool StreamingNFAMatcher::IsAccepting() const { return !is_dead_ && automaton_.IsAccepting(active_); }
+
+bool StreamingNFAMatcher::IsDead() const { return is_dead_; }
+
+uint64_t StreamingNFAMatcher::GetOffset() const { return offset_; }
+
+std::span<const BitParallelNFA::word_t> StreamingNFAMatcher::GetActiveStates() const { return active_; }
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bit_parallel_nfa.hpp"
+#include "compiled_dfa.hpp"
+
+// Resumable matching of input arriving in chunks. A matcher keeps only the
+// state reached after the bytes fed so far, so feeding the chunks one after
+// another gives the same result as matching their concatenation, and the
+// input is never buffered. Matches are prefixes of the whole stream: the
+// callback of Feed gets the offset of the end of every accepted prefix as
+// soon as its last byte is read. Feeding doesn't allocate memory. The
+// automaton must outlive the matcher.
+class StreamingDFAMatcher
+{
+    public:
+        explicit StreamingDFAMatcher(const CompiledDFA &automaton);
+
+        void Reset();
+
+        // Only moves the state.
+        void Feed(std::span<const char> chunk);
+
+        // Calls on_match(end, ids) for every accepted prefix ending in the chunk.
+        template <class callback_t>
+        void Feed(std::span<const char> chunk, callback_t &&on_match)
+        {
+            CompiledDFA::state_t state = state_;
+            const char *begin = chunk.data();
+            const char *end = begin + chunk.size();
+
+            for (const char *position = begin; position != end; ++position)
+            {
+                if (!automaton_.IsAccepting(state))
+                {
+                    position = automaton_.Skip(state, position, end);
+                    if (position == end)
+                        break;
+                }
+
+                state = automaton_.Step(state, static_cast<unsigned char>(*position));
+                if (automaton_.IsAccepting(state))
+                    on_match(offset_ + static_cast<uint64_t>(position - begin) + 1, automaton_.GetAcceptIds(state));
+            }
+
+            state_ = state;
+            offset_ += chunk.size();
+        }
+
+        // Whether the stream read so far is accepted, and the IDs accepting it.
+        bool IsAccepting() const;
+        std::span<const uint32_t> GetAcceptIds() const;
+
+        // No continuation of the stream can be accepted.
+        bool IsDead() const;
+
+        uint64_t GetOffset() const;
+        CompiledDFA::state_t GetState() const;
+
+    private:
+        const CompiledDFA &automaton_;
+        CompiledDFA::state_t state_;
+        uint64_t offset_;
+};
+
+// The same for an NFA: the state is the set of active states, kept in two
+// bitsets allocated once by the constructor.
+class StreamingNFAMatcher
+{
+    public:
+        explicit StreamingNFAMatcher(const BitParallelNFA &automaton);
+
+        void Reset();
+
+        void Feed(std::span<const char> chunk);
+
+        // Calls on_match(end) for every accepted prefix ending in the chunk.
+        template <class callback_t>
+        void Feed(std::span<const char> chunk, callback_t &&on_match)
+        {
+            for (size_t position = 0; position < chunk.size() && !is_dead_; ++position)
+            {
+                is_dead_ = !automaton_.Step(active_, static_cast<unsigned char>(chunk[position]), next_);
+                active_.swap(next_);
+
+                if (!is_dead_ && automaton_.IsAccepting(active_))
+                    on_match(offset_ + position + 1);
+            }
+
+            offset_ += chunk.size();
+        }
+
+        bool IsAccepting() const;
+        bool IsDead() const;
+
+        uint64_t GetOffset() const;
+        std::span<const BitParallelNFA::word_t> GetActiveStates() const;
+
+    private:
+        const BitParallelNFA &automaton_;
+        std::vector<BitParallelNFA::word_t> active_;
+        std::vector<BitParallelNFA::word_t> next_;
+        bool is_dead_;
+        uint64_t offset_;
+};
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <limits>
+
+#include "automaton_statistics.hpp"
+#include "subset_table.hpp"
+
+namespace
+{
+    const size_t Initial_capacity = 16;
+    const size_t Empty_slot = 0;
+
+    uint64_t Mix(uint64_t value)
+    {
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+};
+
+const size_t SubsetTable::NotFound = std::numeric_limits<size_t>::max();
+
+// The hash of a subset is a sum of independently mixed elements, so it can be
+// accumulated while the subset is being collected, in any order.
+uint64_t SubsetTable::HashElement(size_t element) { return Mix(element); }
+
+uint64_t SubsetTable::FinalizeHash(uint64_t accumulated_hash, size_t subset_size)
+{
+    return Mix(accumulated_hash ^ (subset_size * 0xC2B2AE3D27D4EB4Full));
+}
+
+uint64_t SubsetTable::Hash(std::span<const size_t> subset)
+{
+    uint64_t hash = 0;
+    for (auto element : subset)
+        hash += HashElement(element);
+
+    return FinalizeHash(hash, subset.size());
+}
+
+// Unlike Hash, depends on the order of the elements.
+uint64_t SubsetTable::HashSequence(std::span<const uint32_t> sequence)
+{
+    uint64_t hash = sequence.size();
+    for (auto element : sequence)
+        hash = Mix(hash ^ element);
+
+    return hash;
+}
+
+SubsetTable::SubsetTable():
+    elements_(),
+    offsets_(1, 0),
+    hashes_(),
+    final_(),
+    slots_(Initial_capacity, Empty_slot),
+    mask_(Initial_capacity - 1)
+{}
+
+size_t SubsetTable::Find(std::span<const size_t> subset, uint64_t hash) const
+{
+    for (size_t slot = hash & mask_; slots_[slot] != Empty_slot; slot = (slot + 1) & mask_)
+    {
+        AUTOMATON_COUNT(HashProbes, 1);
+
+        size_t index = slots_[slot] - 1;
+        if (Equal(index, subset, hash))
+            return index;
+    }
+
+    return NotFound;
+}
+
+size_t SubsetTable::Find(std::span<const size_t> subset) const { return Find(subset, Hash(subset)); }
+
+size_t SubsetTable::Insert(std::span<const size_t> subset, uint64_t hash, bool is_final)
+{
+    size_t index = Find(subset, hash);
+    if (index != NotFound)
+        return index;
+
+    if (2 * (Size() + 1) > slots_.size())
+        Grow();
+
+    AUTOMATON_COUNT(Subsets, 1);
+
+    index = Size();
+    elements_.insert(elements_.end(), subset.begin(), subset.end());
+    offsets_.push_back(elements_.size());
+    hashes_.push_back(hash);
+    final_.push_back(is_final);
+
+    size_t slot = hash & mask_;
+    while (slots_[slot] != Empty_slot)
+        slot = (slot + 1) & mask_;
+
+    slots_[slot] = index + 1;
+
+    return index;
+}
+
+size_t SubsetTable::Insert(std::span<const size_t> subset, bool is_final)
+{
+    return Insert(subset, Hash(subset), is_final);
+}
+
+std::span<const size_t> SubsetTable::GetSubset(size_t index) const
+{
+    return {elements_.data() + offsets_[index], offsets_[index + 1] - offsets_[index]};
+}
+
+bool SubsetTable::IsFinal(size_t index) const { return final_[index]; }
+
+size_t SubsetTable::Size() const { return hashes_.size(); }
+
+size_t SubsetTable::GetMemoryUsage() const
+{
+    return elements_.size() * sizeof(size_t) + offsets_.size() * sizeof(size_t) +
+           hashes_.size() * sizeof(uint64_t) + final_.size() / 8 + slots_.size() * sizeof(size_t);
+}
+
+void SubsetTable::Clear()
+{
+    elements_.clear();
+    offsets_.assign(1, 0);
+    hashes_.clear();
+    final_.clear();
+    slots_.assign(Initial_capacity, Empty_slot);
+    mask_ = Initial_capacity - 1;
+}
+
+bool SubsetTable::Equal(size_t index, std::span<const size_t> subset, uint64_t hash) const
+{
+    if (hashes_[index] != hash)
+        return false;
+
+    auto stored = GetSubset(index);
+    return std::equal(stored.begin(), stored.end(), subset.begin(), subset.end());
+}
+
+void SubsetTable::Grow()
+{
+    slots_.assign(2 * slots_.size(), Empty_slot);
+    mask_ = slots_.size() - 1;
+
+    for (size_t index = 0; index < Size(); ++index)
+    {
+        size_t slot = hashes_[index] & mask_;
+        while (slots_[slot] != Empty_slot)
+            slot = (slot + 1) & mask_;
+
+        slots_[slot] = index + 1;
+    }
+}
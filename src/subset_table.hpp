@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class SubsetTable
+{
+    public:
+        static const size_t NotFound;
+
+        static uint64_t HashElement(size_t element);
+        static uint64_t FinalizeHash(uint64_t accumulated_hash, size_t subset_size);
+        static uint64_t Hash(std::span<const size_t> subset);
+        static uint64_t HashSequence(std::span<const uint32_t> sequence);
+
+        SubsetTable();
+
+        size_t Find(std::span<const size_t> subset, uint64_t hash) const;
+        size_t Find(std::span<const size_t> subset) const;
+
+        size_t Insert(std::span<const size_t> subset, uint64_t hash, bool is_final);
+        size_t Insert(std::span<const size_t> subset, bool is_final);
+
+        std::span<const size_t> GetSubset(size_t index) const;
+        bool IsFinal(size_t index) const;
+        size_t Size() const;
+        size_t GetMemoryUsage() const;
+
+        void Clear();
+
+    private:
+        std::vector<size_t> elements_;
+        std::vector<size_t> offsets_;
+        std::vector<uint64_t> hashes_;
+        std::vector<bool> final_;
+
+        std::vector<size_t> slots_;
+        size_t mask_;
+
+        bool Equal(size_t index, std::span<const size_t> subset, uint64_t hash) const;
+        void Grow();
+};